@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    Benchmarks.cpp
+    Created: 19 Oct 2026 4:12:31pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+void TimingStats::add(double microseconds)
+{
+    total += microseconds;
+    minimum = juce::jmin(minimum, microseconds);
+    maximum = juce::jmax(maximum, microseconds);
+    ++count;
+}
+
+juce::String TimingStats::toString() const
+{
+    return "mean " + juce::String(getMean(), 2) + " us, min " + juce::String(getMin(), 2)
+        + " us, max " + juce::String(getMax(), 2) + " us (" + juce::String(count) + " runs)";
+}
+
+ScopedBenchmarkTimer::~ScopedBenchmarkTimer()
+{
+    stats.add(ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start));
+}
+
+double ticksToMicroseconds(juce::int64 ticks)
+{
+    return 1.0e6 * double(ticks) / double(juce::Time::getHighResolutionTicksPerSecond());
+}
+
+void setPluginParameter(ParametricEQAudioProcessor& processor, const juce::String& paramID, float value)
+{
+    if (auto* param = processor.tree.getParameter(paramID))
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+}
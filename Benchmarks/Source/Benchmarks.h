@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Created: 19 Oct 2026 4:12:31pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//Timings of one measured operation, in microseconds
+class TimingStats
+{
+public:
+    void add(double microseconds);
+
+    int getCount() const { return count; }
+    double getMean() const { return count > 0 ? total / count : 0.0; }
+    double getMin() const { return count > 0 ? minimum : 0.0; }
+    double getMax() const { return maximum; }
+
+    juce::String toString() const;
+
+private:
+    double total = 0.0;
+    double minimum = std::numeric_limits<double>::max();
+    double maximum = 0.0;
+    int count = 0;
+};
+
+//Adds the time spent in its scope to a TimingStats
+class ScopedBenchmarkTimer
+{
+public:
+    explicit ScopedBenchmarkTimer(TimingStats& s) : stats(s), start(juce::Time::getHighResolutionTicks()) {}
+    ~ScopedBenchmarkTimer();
+
+private:
+    TimingStats& stats;
+    const juce::int64 start;
+};
+
+double ticksToMicroseconds(juce::int64 ticks);
+
+//Sets a parameter the way a host would, in its own units
+void setPluginParameter(ParametricEQAudioProcessor& processor, const juce::String& paramID, float value);
+
+//Each benchmark prints its results and returns false if it failed or missed a target
+bool runRecallBenchmark();
+bool runBlockSizeBenchmark();
+bool runMatchFitBenchmark();
+bool runTimeBlockedBenchmark();
+bool runInstantiationBenchmark();
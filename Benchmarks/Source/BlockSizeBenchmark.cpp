@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    BlockSizeBenchmark.cpp
+    Created: 19 Oct 2026 4:41:52pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+//Cost per call at the small block sizes hosts use for low latency, where the fixed work of a
+//call outweighs the filtering. The ProcessorChain the plugin used to run is the baseline, the
+//bare BiquadCascade the floor, and processBlock everything the host actually calls. Fails if
+//the cascade is not faster than the chain at any of the low latency block sizes.
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+    constexpr int signalLength = 1 << 16;
+    constexpr int samplesPerRun = 1 << 21;
+    constexpr int largestLowLatencyBlockSize = 64;
+
+    using Processor = ParametricEQAudioProcessor;
+
+    struct BandDesign
+    {
+        float cutoff[4], q[4], gainDB[4];
+        bool active[4];
+        int type[4], slope[4];
+    };
+
+    BandDesign readBands(Processor& processor)
+    {
+        BandDesign bands;
+        for (int i = 0; i < 4; ++i)
+        {
+            bands.cutoff[i] = *processor.tree.getRawParameterValue(processor.getFilterCutoffParamName(i));
+            bands.q[i] = *processor.tree.getRawParameterValue(processor.getFilterQParamName(i));
+            bands.gainDB[i] = *processor.tree.getRawParameterValue(processor.getFilterGainParamName(i));
+            bands.active[i] = *processor.tree.getRawParameterValue(processor.getFilterActiveName(i)) >= 0.5f;
+            bands.type[i] = Processor::hasFilterType(i) ? juce::roundToInt(processor.tree.getRawParameterValue(processor.getFilterTypeName(i))->load()) : int(Processor::shelfType);
+            bands.slope[i] = Processor::hasFilterType(i) ? juce::roundToInt(processor.tree.getRawParameterValue(processor.getFilterSlopeName(i))->load()) : 0;
+        }
+        return bands;
+    }
+
+    void fillNoise(juce::AudioBuffer<float>& signal)
+    {
+        juce::Random random(1);
+        for (int ch = 0; ch < signal.getNumChannels(); ++ch)
+            for (int n = 0; n < signal.getNumSamples(); ++n)
+                signal.setSample(ch, n, random.nextFloat() - 0.5f);
+    }
+
+    //Calls process on consecutive blocks of a long noise signal and returns nanoseconds per call
+    template <typename ProcessFunction>
+    double timeCalls(juce::AudioBuffer<float>& signal, int blockSize, ProcessFunction&& process)
+    {
+        const int blocksPerPass = signalLength / blockSize;
+        const int numPasses = juce::jmax(1, samplesPerRun / (blocksPerPass * blockSize));
+        float* channels[numChannels];
+
+        juce::int64 ticks = 0;
+        for (int pass = 0; pass < numPasses; ++pass)
+        {
+            //Fresh input each pass, so the output never runs away through repeated gain
+            fillNoise(signal);
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int block = 0; block < blocksPerPass; ++block)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    channels[ch] = signal.getWritePointer(ch, block * blockSize);
+                process(channels, blockSize);
+            }
+            ticks += juce::Time::getHighResolutionTicks() - start;
+        }
+        return 1000.0 * ticksToMicroseconds(ticks) / double(numPasses * blocksPerPass);
+    }
+}
+
+bool runBlockSizeBenchmark()
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    //A program with every band active, so no engine skips work the others do
+    Processor processor;
+    processor.setCurrentProgram(3);
+    const auto bands = readBands(processor);
+
+    juce::AudioBuffer<float> signal(numChannels, signalLength);
+    juce::MidiBuffer midi;
+
+    std::cout << "  block   ProcessorChain   BiquadCascade   processBlock   (ns per call)   processBlock overhead" << std::endl;
+
+    bool passed = true;
+    for (int blockSize : { 1, 8, 32, 64, 512 })
+    {
+        Processor::FilterChain chain;
+        juce::dsp::ProcessSpec spec { sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+        chain.prepare(spec);
+        bool bypassed[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            Processor::getChainCoefficients(chain, i) = *Processor::makeBandCoefficients(i, bands.cutoff[i], bands.q[i], bands.gainDB[i], sampleRate);
+            bypassed[i] = !bands.active[i];
+        }
+        Processor::setChainBypassed(chain, bypassed);
+
+        BiquadCascade cascade;
+        for (int i = 0; i < 4; ++i)
+        {
+            float sections[BiquadCascade::maxSectionsPerBand][5];
+            const int numSections = Processor::makeBandSections(i, bands.type[i], bands.slope[i], bands.cutoff[i], bands.q[i], bands.gainDB[i], sampleRate, sections);
+            cascade.setBandSections(i, sections, numSections);
+            cascade.setBandBypassed(i, !bands.active[i]);
+        }
+        cascade.prepare(numChannels);
+
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        const double chainTime = timeCalls(signal, blockSize, [&](float** channels, int numSamples)
+        {
+            juce::dsp::AudioBlock<float> block(channels, numChannels, size_t(numSamples));
+            chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+        });
+
+        const double cascadeTime = timeCalls(signal, blockSize, [&](float** channels, int numSamples)
+        {
+            cascade.process(channels, numChannels, numSamples);
+        });
+
+        const double processBlockTime = timeCalls(signal, blockSize, [&](float** channels, int numSamples)
+        {
+            juce::AudioBuffer<float> buffer(channels, numChannels, numSamples);
+            processor.processBlock(buffer, midi);
+        });
+
+        processor.releaseResources();
+
+        std::cout << "  " << juce::String(blockSize).paddedLeft(' ', 5)
+                  << juce::String(chainTime, 1).paddedLeft(' ', 17)
+                  << juce::String(cascadeTime, 1).paddedLeft(' ', 16)
+                  << juce::String(processBlockTime, 1).paddedLeft(' ', 15)
+                  << juce::String(processBlockTime - cascadeTime, 1).paddedLeft(' ', 40);
+
+        if (blockSize <= largestLowLatencyBlockSize && cascadeTime >= chainTime)
+        {
+            std::cout << "   cascade SLOWER than the chain";
+            passed = false;
+        }
+        std::cout << std::endl;
+    }
+    return passed;
+}
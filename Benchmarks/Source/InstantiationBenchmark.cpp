@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    InstantiationBenchmark.cpp
+    Created: 19 Oct 2026 6:07:14pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+//Defined with the processor; what every host calls to make an instance
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//What opening a session costs per instance: construction the way a host does it, a stereo
+//prepareToPlay and an editor that is created but not shown yet, which builds neither its band
+//controls nor its plots until it is. Each has a target for a
+//release build on a desktop machine, held against the mean over a session's worth of instances.
+namespace
+{
+    constexpr int numInstances = 100;
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    constexpr double constructorTargetMicroseconds = 1000.0;
+    constexpr double prepareTargetMicroseconds = 1000.0;
+    constexpr double createEditorTargetMicroseconds = 5000.0;
+
+    bool report(const char* name, const TimingStats& stats, double targetMicroseconds)
+    {
+        const bool met = stats.getMean() < targetMicroseconds;
+        std::cout << "  " << name << ": " << stats.toString() << ", target " << juce::String(targetMicroseconds, 0)
+                  << " us" << (met ? "" : " MISSED") << std::endl;
+        return met;
+    }
+}
+
+bool runInstantiationBenchmark()
+{
+    //All kept alive, as in a session, so later instances aren't built in the memory of earlier ones
+    std::vector<std::unique_ptr<juce::AudioProcessor>> instances;
+    TimingStats constructorStats, prepareStats, createEditorStats;
+    bool plotsDeferred = true;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        {
+            ScopedBenchmarkTimer timer(constructorStats);
+            instances.emplace_back(createPluginFilter());
+        }
+        auto& instance = *instances.back();
+
+        {
+            ScopedBenchmarkTimer timer(prepareStats);
+            instance.prepareToPlay(sampleRate, blockSize);
+        }
+
+        std::unique_ptr<juce::AudioProcessorEditor> editor;
+        {
+            ScopedBenchmarkTimer timer(createEditorStats);
+            editor.reset(instance.createEditor());
+        }
+
+        //Nothing has shown the editor, so nothing may have computed a plot or built a band's
+        //controls: its only children are the three match buttons
+        if (!static_cast<ParametricEQAudioProcessor&>(instance).getMagnitudes(4).empty() || editor->getNumChildComponents() > 3)
+            plotsDeferred = false;
+
+        editor.reset();
+    }
+
+    if (!plotsDeferred)
+        std::cout << "  an editor that was never shown computed the plots or built the band controls" << std::endl;
+
+    const bool constructorMet = report("constructor", constructorStats, constructorTargetMicroseconds);
+    const bool prepareMet = report("prepareToPlay", prepareStats, prepareTargetMicroseconds);
+    const bool createEditorMet = report("createEditor", createEditorStats, createEditorTargetMicroseconds);
+    return plotsDeferred && constructorMet && prepareMet && createEditorMet;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    Runs the plugin's benchmarks. With no arguments every benchmark runs, otherwise
+    only the ones named. Exits nonzero if any of them failed or missed its target.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Benchmarks.h"
+
+struct Benchmark
+{
+    const char* name;
+    bool (*run)();
+};
+
+static const Benchmark benchmarks[] =
+{
+    { "recall", runRecallBenchmark },
+    { "blocksizes", runBlockSizeBenchmark },
+    { "matchfit", runMatchFitBenchmark },
+    { "timeblocked", runTimeBlockedBenchmark },
+    { "instantiation", runInstantiationBenchmark }
+};
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray requested;
+    for (int i = 1; i < argc; ++i)
+        requested.add(argv[i]);
+
+    bool allPassed = true;
+    int numRun = 0;
+    for (auto& benchmark : benchmarks)
+    {
+        if (!requested.isEmpty() && !requested.contains(benchmark.name))
+            continue;
+
+        std::cout << "== " << benchmark.name << std::endl;
+        allPassed = benchmark.run() && allPassed;
+        ++numRun;
+    }
+
+    if (numRun == 0)
+    {
+        std::cout << "Usage: parametricEQBenchmarks [benchmark...]" << std::endl << "Benchmarks:";
+        for (auto& benchmark : benchmarks)
+            std::cout << " " << benchmark.name;
+        std::cout << std::endl;
+        return 2;
+    }
+
+    return allPassed ? 0 : 1;
+}
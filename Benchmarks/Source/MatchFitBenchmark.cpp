@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    MatchFitBenchmark.cpp
+    Created: 19 Oct 2026 5:02:17pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+//Time from startMatch to the fitted bands arriving on the message thread. The reference is
+//noise through a known program and the learnt input is the same noise unfiltered, so the
+//fit has an exact answer to find.
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int signalSeconds = 8;
+    constexpr int numRuns = 3;
+
+    bool writeReference(const juce::File& file, const juce::AudioBuffer<float>& noise, int program)
+    {
+        ParametricEQAudioProcessor shaper;
+        shaper.setCurrentProgram(program);
+        shaper.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> reference(noise);
+        juce::MidiBuffer midi;
+        for (int start = 0; start < reference.getNumSamples(); start += blockSize)
+        {
+            juce::AudioBuffer<float> block(reference.getArrayOfWritePointers(), reference.getNumChannels(), start,
+                                           juce::jmin(blockSize, reference.getNumSamples() - start));
+            shaper.processBlock(block, midi);
+        }
+
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, juce::uint32(reference.getNumChannels()), 24, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release();
+        return writer->writeFromAudioSampleBuffer(reference, 0, reference.getNumSamples());
+    }
+
+    template <typename Condition>
+    bool waitFor(Condition&& condition, int timeoutMs)
+    {
+        const auto end = juce::Time::getMillisecondCounter() + juce::uint32(timeoutMs);
+        while (!condition())
+        {
+            if (juce::Time::getMillisecondCounter() > end)
+                return false;
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+        }
+        return true;
+    }
+}
+
+bool runMatchFitBenchmark()
+{
+    juce::AudioBuffer<float> noise(2, int(sampleRate) * signalSeconds);
+    juce::Random random(7);
+    for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+        for (int n = 0; n < noise.getNumSamples(); ++n)
+            noise.setSample(ch, n, 0.25f * (random.nextFloat() - 0.5f));
+
+    juce::TemporaryFile referenceFile(".wav");
+    juce::TemporaryFile staleFile(".wav");
+    if (!writeReference(referenceFile.getFile(), noise, 3) || !writeReference(staleFile.getFile(), noise, 7))
+    {
+        std::cout << "  could not write the reference files" << std::endl;
+        return false;
+    }
+
+    ParametricEQAudioProcessor processor;
+    processor.prepareToPlay(sampleRate, blockSize);
+    auto& match = processor.getMatchEQ();
+
+    //Learn the unfiltered noise; the analysis thread drains the input every 20 ms
+    match.setLearning(true);
+    juce::MidiBuffer midi;
+    for (int start = 0; start < noise.getNumSamples(); start += blockSize)
+    {
+        juce::AudioBuffer<float> block(noise.getArrayOfWritePointers(), noise.getNumChannels(), start,
+                                       juce::jmin(blockSize, noise.getNumSamples() - start));
+        juce::AudioBuffer<float> copy(block);
+        processor.processBlock(copy, midi);
+        if ((start / blockSize) % 64 == 63)
+            juce::Thread::sleep(25);
+    }
+    juce::Thread::sleep(50);
+    match.setLearning(false);
+
+    //A reference replaced while it is still being analysed must never be the one that sticks
+    match.analyseReference(staleFile.getFile());
+    match.analyseReference(referenceFile.getFile());
+    if (!waitFor([&] { return match.hasReference(); }, 30000) || !match.hasTarget())
+    {
+        std::cout << "  the spectra were never ready" << std::endl;
+        return false;
+    }
+
+    TimingStats wallTime, fitTime;
+    double worstErrorDB = 0.0;
+    for (int run = 0; run < numRuns; ++run)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        if (!processor.startMatch())
+        {
+            std::cout << "  the fit did not start" << std::endl;
+            return false;
+        }
+
+        bool finished = false;
+        MatchEQ::Result result {};
+        auto applyResult = match.onFitFinished;
+        match.onFitFinished = [&](const MatchEQ::Result& r)
+        {
+            applyResult(r);
+            result = r;
+            finished = true;
+        };
+
+        if (!waitFor([&] { return finished; }, 60000))
+        {
+            std::cout << "  the fit never finished" << std::endl;
+            return false;
+        }
+
+        wallTime.add(ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start));
+        fitTime.add(result.fitSeconds * 1.0e6);
+        worstErrorDB = juce::jmax(worstErrorDB, result.rmsErrorDB);
+    }
+
+    std::cout << "  fit on the islands: " << fitTime.toString() << std::endl
+              << "  startMatch to result: " << wallTime.toString() << std::endl
+              << "  worst rms error: " << juce::String(worstErrorDB, 3) << " dB" << std::endl;
+
+    //The stale reference is the telephone program, which the shelves and peaks can't follow
+    //within 1 dB, so this also fails if the superseded analysis was the one kept
+    return worstErrorDB < 1.0;
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    RecallBenchmark.cpp
+    Created: 19 Oct 2026 4:20:08pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+//Time to recall a session into each instance of a project's worth of them, for the binary
+//state and for the XML state older versions saved
+namespace
+{
+    constexpr int numInstances = 100;
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    void configure(ParametricEQAudioProcessor& processor)
+    {
+        const float cutoffs[4] = { 80.0f, 420.0f, 2600.0f, 9000.0f };
+        for (int i = 0; i < 4; ++i)
+        {
+            setPluginParameter(processor, processor.getFilterCutoffParamName(i), cutoffs[i]);
+            setPluginParameter(processor, processor.getFilterQParamName(i), 1.3f);
+            setPluginParameter(processor, processor.getFilterGainParamName(i), i % 2 == 0 ? 4.5f : -3.0f);
+            setPluginParameter(processor, processor.getFilterActiveName(i), 1.0f);
+        }
+        setPluginParameter(processor, processor.getFilterTypeName(0), float(ParametricEQAudioProcessor::butterworthCut));
+        setPluginParameter(processor, processor.getFilterSlopeName(0), 3.0f);
+        processor.storeProgram(1);
+        processor.changeProgramName(1, "Recall benchmark");
+    }
+
+    bool matches(ParametricEQAudioProcessor& recalled, ParametricEQAudioProcessor& source)
+    {
+        for (auto* param : source.getParameters())
+        {
+            auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param);
+            if (ranged == nullptr)
+                continue;
+
+            auto* other = recalled.tree.getParameter(ranged->paramID);
+            if (other == nullptr || std::abs(other->getValue() - ranged->getValue()) > 1.0e-6f)
+            {
+                std::cout << "  " << ranged->paramID << " was not recalled" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool timeRecall(const juce::String& format, const juce::MemoryBlock& state, ParametricEQAudioProcessor& source, bool checkPrograms)
+    {
+        std::vector<std::unique_ptr<ParametricEQAudioProcessor>> instances;
+        for (int i = 0; i < numInstances; ++i)
+        {
+            instances.push_back(std::make_unique<ParametricEQAudioProcessor>());
+            instances.back()->prepareToPlay(sampleRate, blockSize);
+        }
+
+        TimingStats stats;
+        for (auto& instance : instances)
+        {
+            ScopedBenchmarkTimer timer(stats);
+            instance->setStateInformation(state.getData(), int(state.getSize()));
+        }
+
+        std::cout << "  " << format << " (" << juce::String(int(state.getSize())) << " bytes): " << stats.toString() << std::endl;
+
+        for (auto& instance : instances)
+        {
+            if (!matches(*instance, source))
+                return false;
+            if (checkPrograms && instance->getProgramName(1) != source.getProgramName(1))
+            {
+                std::cout << "  stored programs were not recalled" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool runRecallBenchmark()
+{
+    ParametricEQAudioProcessor source;
+    source.prepareToPlay(sampleRate, blockSize);
+    configure(source);
+
+    juce::MemoryBlock binaryState;
+    source.getStateInformation(binaryState);
+
+    juce::MemoryBlock xmlState;
+    if (auto xml = source.tree.copyState().createXml())
+        juce::AudioProcessor::copyXmlToBinary(*xml, xmlState);
+
+    //A truncated session must be rejected without touching the instance
+    ParametricEQAudioProcessor truncated;
+    truncated.setStateInformation(binaryState.getData(), int(binaryState.getSize()) / 2);
+    const bool rejectedTruncated = truncated.tree.getParameter(truncated.getFilterCutoffParamName(0))->getValue()
+        != source.tree.getParameter(source.getFilterCutoffParamName(0))->getValue();
+    if (!rejectedTruncated)
+        std::cout << "  a truncated session was partly applied" << std::endl;
+
+    const bool binaryPassed = timeRecall("binary", binaryState, source, true);
+    const bool xmlPassed = timeRecall("xml", xmlState, source, false);
+    return rejectedTruncated && binaryPassed && xmlPassed;
+}
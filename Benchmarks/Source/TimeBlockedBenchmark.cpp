@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    TimeBlockedBenchmark.cpp
+    Created: 19 Oct 2026 5:48:36pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+
+//The time blocked kernel against the fused recursion: accuracy against a double precision run
+//of the same sections, throughput on long buffers, and what a band change costs the audio
+//thread with the kernel off and on. Fails if the kernel falls below the validator's 70 dB.
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int signalLength = 1 << 16;
+    constexpr int accuracyBlockSize = 509;
+    constexpr int throughputBlockSize = 4096;
+    constexpr int throughputPasses = 500;
+    constexpr int numUpdates = 20000;
+    constexpr double minimumSnrDB = 70.0;
+
+    using Processor = ParametricEQAudioProcessor;
+
+    struct Configuration
+    {
+        const char* name;
+        int type[4], slope[4];
+        float cutoff[4], q[4], gainDB[4];
+    };
+
+    //A program's shelves and peaks, then the validator's two cut configurations
+    const Configuration configurations[] =
+    {
+        { "Vocal Presence", { 0, 0, 0, 0 }, { 1, 1, 1, 1 }, { 100.0f, 300.0f, 3500.0f, 10000.0f }, { 0.7f, 1.5f, 1.2f, 0.7f }, { -4.0f, -2.0f, 3.0f, 2.0f } },
+        { "48 dB/oct cuts", { Processor::butterworthCut, 0, 0, Processor::linkwitzRileyCut }, { 3, 1, 1, 3 },
+          { 100.0f, 400.0f, 3000.0f, 8000.0f }, { 0.7f, 1.0f, 1.2f, 0.7f }, { 0.0f, -3.0f, 2.0f, 0.0f } },
+        { "96 dB/oct cuts", { Processor::linkwitzRileyCut, 0, 0, Processor::butterworthCut }, { 1, 1, 1, 5 },
+          { 60.0f, 400.0f, 3000.0f, 12000.0f }, { 0.7f, 1.0f, 1.2f, 0.7f }, { 0.0f, -3.0f, 2.0f, 0.0f } }
+    };
+
+    struct Sections
+    {
+        float coefficients[4][BiquadCascade::maxSectionsPerBand][5];
+        int numSections[4];
+    };
+
+    Sections makeSections(const Configuration& configuration)
+    {
+        Sections sections;
+        for (int i = 0; i < 4; ++i)
+            sections.numSections[i] = Processor::makeBandSections(i, configuration.type[i], configuration.slope[i], configuration.cutoff[i],
+                                                                  configuration.q[i], configuration.gainDB[i], sampleRate, sections.coefficients[i]);
+        return sections;
+    }
+
+    void loadSections(BiquadCascade& cascade, const Sections& sections)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            cascade.setBandSections(i, sections.coefficients[i], sections.numSections[i]);
+            cascade.setBandBypassed(i, false);
+        }
+        cascade.prepare(1);
+        cascade.reset();
+    }
+
+    //The same sections and the same TDF-II arithmetic as the cascade, in double
+    std::vector<double> runReference(const Sections& sections, const std::vector<float>& input)
+    {
+        std::vector<double> output(input.begin(), input.end());
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int k = 0; k < sections.numSections[i]; ++k)
+            {
+                const float* c = sections.coefficients[i][k];
+                double s1 = 0.0, s2 = 0.0;
+                for (auto& x : output)
+                {
+                    const double y = x * c[0] + s1;
+                    s1 = x * c[1] - y * c[3] + s2;
+                    s2 = x * c[2] - y * c[4];
+                    x = y;
+                }
+            }
+        }
+        return output;
+    }
+
+    double runAndMeasureSnr(BiquadCascade& cascade, const std::vector<float>& input, const std::vector<double>& reference)
+    {
+        std::vector<float> output(input);
+        for (int start = 0; start < signalLength; start += accuracyBlockSize)
+        {
+            float* channel = output.data() + start;
+            cascade.process(&channel, 1, juce::jmin(accuracyBlockSize, signalLength - start));
+        }
+
+        double signal = 0.0, error = 0.0;
+        for (size_t n = 0; n < output.size(); ++n)
+        {
+            signal += reference[n] * reference[n];
+            error += (output[n] - reference[n]) * (output[n] - reference[n]);
+        }
+        return error > 0.0 ? 10.0 * std::log10(signal / error) : 999.0;
+    }
+
+    double measureThroughput(BiquadCascade& cascade, std::vector<float>& buffer)
+    {
+        float* channel = buffer.data();
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int pass = 0; pass < throughputPasses; ++pass)
+            cascade.process(&channel, 1, throughputBlockSize);
+        const double seconds = ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start) * 1.0e-6;
+        return double(throughputPasses) * throughputBlockSize / seconds * 1.0e-6;
+    }
+
+    //A band change and the one sample call that applies it, as automation on the audio thread does
+    double measureUpdateCost(const Sections& sections, bool timeBlocked)
+    {
+        BiquadCascade cascade;
+        loadSections(cascade, sections);
+        cascade.setTimeBlockedProcessing(timeBlocked);
+
+        float sample = 0.0f;
+        float* channel = &sample;
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int n = 0; n < numUpdates; ++n)
+        {
+            cascade.setBandSections(3, sections.coefficients[3], sections.numSections[3]);
+            cascade.process(&channel, 1, 1);
+        }
+        return 1000.0 * ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start) / numUpdates;
+    }
+}
+
+bool runTimeBlockedBenchmark()
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    std::vector<float> input(signalLength);
+    juce::Random random(3);
+    for (auto& x : input)
+        x = random.nextFloat() - 0.5f;
+
+    std::cout << "  configuration      SNR recursion   SNR blocked   Msamples/s recursion   blocked   speedup" << std::endl;
+
+    bool passed = true;
+    for (auto& configuration : configurations)
+    {
+        const auto sections = makeSections(configuration);
+        const auto reference = runReference(sections, input);
+
+        BiquadCascade recursion, blocked;
+        loadSections(recursion, sections);
+        loadSections(blocked, sections);
+        blocked.setTimeBlockedProcessing(true);
+
+        const double recursionSnr = runAndMeasureSnr(recursion, input, reference);
+        const double blockedSnr = runAndMeasureSnr(blocked, input, reference);
+
+        std::vector<float> buffer(input.begin(), input.begin() + throughputBlockSize);
+        const double recursionRate = measureThroughput(recursion, buffer);
+        std::copy_n(input.begin(), throughputBlockSize, buffer.begin());
+        const double blockedRate = measureThroughput(blocked, buffer);
+
+        std::cout << "  " << juce::String(configuration.name).paddedRight(' ', 17)
+                  << juce::String(recursionSnr, 1).paddedLeft(' ', 15) << " dB"
+                  << juce::String(blockedSnr, 1).paddedLeft(' ', 11) << " dB"
+                  << juce::String(recursionRate, 1).paddedLeft(' ', 23)
+                  << juce::String(blockedRate, 1).paddedLeft(' ', 10)
+                  << juce::String(blockedRate / recursionRate, 2).paddedLeft(' ', 9) << "x" << std::endl;
+
+        passed = passed && blockedSnr >= minimumSnrDB;
+    }
+
+    //The 96 dB/oct high cut has the most sections to remake per change
+    const auto steepest = makeSections(configurations[2]);
+    std::cout << "  band change with the kernel off: " << juce::String(measureUpdateCost(steepest, false), 1) << " ns, on: "
+              << juce::String(measureUpdateCost(steepest, true), 1) << " ns" << std::endl;
+
+    return passed;
+}
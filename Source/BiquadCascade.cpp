@@ -0,0 +1,381 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.cpp
+    Created: 19 Oct 2026 1:55:21pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "BiquadCascade.h"
+
+BiquadCascade::BiquadCascade()
+{
+    for (int i = 0; i < maxBands; ++i)
+    {
+        staged.sections[i][0] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        staged.numSections[i] = 1;
+        staged.shape[i] = 0;
+        staged.bypassed[i] = true;
+        staged.sectionSequence[i] = 0;
+        staged.bypassSequence[i] = 0;
+        numSections[i] = 1;
+        shapes[i] = 0;
+    }
+    pending = staged;
+}
+
+void BiquadCascade::prepare(int numChannels)
+{
+    numPreparedChannels = numChannels;
+    state.assign(size_t(numChannels * statePerChannel), 0.0f);
+
+    const juce::SpinLock::ScopedLockType sl(pendingLock);
+    mergePendingChanges();
+    applyStagedChanges();
+}
+
+void BiquadCascade::reset() noexcept
+{
+    std::fill(state.begin(), state.end(), 0.0f);
+}
+
+bool BiquadCascade::isAudioThread() const noexcept
+{
+    return audioThread.load(std::memory_order_relaxed) == juce::Thread::getCurrentThreadId();
+}
+
+void BiquadCascade::setBandSections(int band, const float (*coefficients)[5], int numBandSections, int shape) noexcept
+{
+    jassert(numBandSections > 0 && numBandSections <= maxSectionsPerBand);
+
+    auto write = [&](StagedBands& bands)
+    {
+        for (int i = 0; i < numBandSections; ++i)
+            bands.sections[band][i] = { coefficients[i][0], coefficients[i][1], coefficients[i][2], coefficients[i][3], coefficients[i][4] };
+        bands.numSections[band] = numBandSections;
+        bands.shape[band] = shape;
+        bands.sectionSequence[band] = ++writeSequence;
+    };
+
+    if (isAudioThread())
+    {
+        write(staged);
+        hasStagedChanges = true;
+        return;
+    }
+
+    const juce::SpinLock::ScopedLockType sl(pendingLock);
+    write(pending);
+    hasPendingChanges.store(true, std::memory_order_release);
+}
+
+void BiquadCascade::setBandBypassed(int band, bool bypassed) noexcept
+{
+    if (isAudioThread())
+    {
+        staged.bypassed[band] = bypassed;
+        staged.bypassSequence[band] = ++writeSequence;
+        hasStagedChanges = true;
+        return;
+    }
+
+    const juce::SpinLock::ScopedLockType sl(pendingLock);
+    pending.bypassed[band] = bypassed;
+    pending.bypassSequence[band] = ++writeSequence;
+    hasPendingChanges.store(true, std::memory_order_release);
+}
+
+void BiquadCascade::mergePendingChanges() noexcept
+{
+    //With pendingLock held. A pending write older than one the audio thread made since loses.
+    hasPendingChanges.store(false, std::memory_order_relaxed);
+
+    auto isNewer = [](juce::uint32 a, juce::uint32 b) { return juce::int32(a - b) > 0; };
+    for (int band = 0; band < maxBands; ++band)
+    {
+        if (isNewer(pending.sectionSequence[band], staged.sectionSequence[band]))
+        {
+            std::copy_n(pending.sections[band], pending.numSections[band], staged.sections[band]);
+            staged.numSections[band] = pending.numSections[band];
+            staged.shape[band] = pending.shape[band];
+            staged.sectionSequence[band] = pending.sectionSequence[band];
+            hasStagedChanges = true;
+        }
+
+        if (isNewer(pending.bypassSequence[band], staged.bypassSequence[band]))
+        {
+            staged.bypassed[band] = pending.bypassed[band];
+            staged.bypassSequence[band] = pending.bypassSequence[band];
+            hasStagedChanges = true;
+        }
+    }
+}
+
+void BiquadCascade::applyStagedChanges() noexcept
+{
+    hasStagedChanges = false;
+
+    numActiveSections = 0;
+    for (int band = 0; band < maxBands; ++band)
+    {
+        //A band that changes shape starts from silence, and so do sections a band gains, rather
+        //than from whatever they held last time
+        const int firstCleared = staged.shape[band] != shapes[band] ? 0 : numSections[band];
+        if (staged.numSections[band] > firstCleared)
+        {
+            for (int ch = 0; ch < numPreparedChannels; ++ch)
+            {
+                float* bandState = state.data() + ch * statePerChannel + band * maxSectionsPerBand * 2;
+                std::fill(bandState + firstCleared * 2, bandState + staged.numSections[band] * 2, 0.0f);
+            }
+        }
+        numSections[band] = staged.numSections[band];
+        shapes[band] = staged.shape[band];
+        if (staged.sectionSequence[band] != appliedSequence[band])
+        {
+            appliedSequence[band] = staged.sectionSequence[band];
+            staleBlockBands |= 1 << band;
+        }
+
+        if (staged.bypassed[band])
+            continue;
+
+        for (int i = 0; i < numSections[band]; ++i)
+        {
+            activeSections[numActiveSections] = staged.sections[band][i];
+            activeStateIndex[numActiveSections] = (band * maxSectionsPerBand + i) * 2;
+            ++numActiveSections;
+        }
+    }
+
+    if (timeBlocked)
+        updateBlockSections();
+}
+
+void BiquadCascade::updateBlockSections() noexcept
+{
+    //Only the active bands that changed; a bypassed band's stay stale until it is switched back on
+    if (staleBlockBands == 0)
+        return;
+
+    int madeBands = 0;
+    for (int i = 0; i < numActiveSections; ++i)
+    {
+        const int index = activeStateIndex[i] / 2;
+        const int band = index / maxSectionsPerBand;
+        if ((staleBlockBands & (1 << band)) == 0)
+            continue;
+
+        makeBlockSection(activeSections[i], blockSections[index]);
+        madeBands |= 1 << band;
+    }
+    staleBlockBands &= ~madeBands;
+}
+
+void BiquadCascade::makeBlockSection(const Section& s, BlockSection& block) noexcept
+{
+    //TDF-II as a state-space system: y = s1 + b0 x, [s1, s2] = A [s1, s2] + g x, with
+    //A = [-a1 1; -a2 0] and g = [b1 - a1 b0, b2 - a2 b0]. Powers of A are taken in double.
+    const double a[2][2] = { { -double(s.a1), 1.0 }, { -double(s.a2), 0.0 } };
+    const double g[2] = { double(s.b1) - double(s.a1) * s.b0, double(s.b2) - double(s.a2) * s.b0 };
+
+    //powers[k] = A^k
+    double powers[timeBlockLength + 1][2][2] = { { { 1.0, 0.0 }, { 0.0, 1.0 } } };
+    for (int k = 1; k <= timeBlockLength; ++k)
+        for (int r = 0; r < 2; ++r)
+            for (int c = 0; c < 2; ++c)
+                powers[k][r][c] = a[r][0] * powers[k - 1][0][c] + a[r][1] * powers[k - 1][1][c];
+
+    //Impulse response h[0] = b0, h[k] = first row of A^(k-1) g
+    double impulse[timeBlockLength];
+    impulse[0] = s.b0;
+    for (int k = 1; k < timeBlockLength; ++k)
+        impulse[k] = powers[k - 1][0][0] * g[0] + powers[k - 1][0][1] * g[1];
+
+    for (int j = 0; j < timeBlockLength; ++j)
+        for (int k = 0; k < timeBlockLength; ++k)
+            block.inputToOutput[j][k] = k >= j ? float(impulse[k - j]) : 0.0f;
+
+    for (int r = 0; r < 2; ++r)
+    {
+        for (int k = 0; k < timeBlockLength; ++k)
+        {
+            block.stateToOutput[r][k] = float(powers[k][0][r]);
+            const auto& p = powers[timeBlockLength - 1 - k];
+            block.inputToState[r][k] = float(p[r][0] * g[0] + p[r][1] * g[1]);
+        }
+        block.stateToState[r][0] = float(powers[timeBlockLength][r][0]);
+        block.stateToState[r][1] = float(powers[timeBlockLength][r][1]);
+    }
+}
+
+void BiquadCascade::setTimeBlockedProcessing(bool shouldUseTimeBlocks) noexcept
+{
+   #if JUCE_USE_SIMD
+    //Switching on makes whatever changed while it was off
+    if (shouldUseTimeBlocks && !timeBlocked)
+        updateBlockSections();
+    timeBlocked = shouldUseTimeBlocks;
+   #else
+    juce::ignoreUnused(shouldUseTimeBlocks);
+   #endif
+}
+
+void BiquadCascade::registerAudioThread() noexcept
+{
+    //From here on writes from this thread skip the lock
+    audioThread.store(juce::Thread::getCurrentThreadId(), std::memory_order_relaxed);
+}
+
+void BiquadCascade::update() noexcept
+{
+    registerAudioThread();
+
+    //Never waits: if a writer holds the lock its change is picked up on the next call
+    if (hasPendingChanges.load(std::memory_order_acquire))
+    {
+        const juce::SpinLock::ScopedTryLockType sl(pendingLock);
+        if (sl.isLocked())
+            mergePendingChanges();
+    }
+
+    if (hasStagedChanges)
+        applyStagedChanges();
+}
+
+void BiquadCascade::process(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    update();
+    processChannels(channels, 0, numChannels, numSamples);
+}
+
+template <int numFused>
+void BiquadCascade::processFused(float* data, int numSamples, const Section* s, const int* stateIndex, float* channelState) noexcept
+{
+    //All sections run back to back on each sample, so the buffer is read and written once however
+    //many sections there are. The state lives in locals the compiler can keep in registers.
+    float lv1[numFused], lv2[numFused];
+    for (int k = 0; k < numFused; ++k)
+    {
+        lv1[k] = channelState[stateIndex[k]];
+        lv2[k] = channelState[stateIndex[k] + 1];
+    }
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        float input = data[n];
+        for (int k = 0; k < numFused; ++k)
+        {
+            //Transposed direct form II, the same arithmetic as IIR::Filter
+            const float output = input * s[k].b0 + lv1[k];
+            lv1[k] = (input * s[k].b1) - (output * s[k].a1) + lv2[k];
+            lv2[k] = (input * s[k].b2) - (output * s[k].a2);
+            input = output;
+        }
+        data[n] = input;
+    }
+
+    for (int k = 0; k < numFused; ++k)
+    {
+        juce::dsp::util::snapToZero(lv1[k]);
+        juce::dsp::util::snapToZero(lv2[k]);
+        channelState[stateIndex[k]] = lv1[k];
+        channelState[stateIndex[k] + 1] = lv2[k];
+    }
+}
+
+void BiquadCascade::processTimeBlocked(float* data, int numSamples, float* channelState) noexcept
+{
+    //Section by section over the whole buffer. Only the 2x2 state update links one block to the
+    //next; the input terms of every block are independent, so they overlap with it.
+    for (int i = 0; i < numActiveSections; ++i)
+    {
+        const auto& s = activeSections[i];
+        float lv1 = channelState[activeStateIndex[i]];
+        float lv2 = channelState[activeStateIndex[i] + 1];
+        int n = 0;
+
+       #if JUCE_USE_SIMD
+        const auto& b = blockSections[activeStateIndex[i] / 2];
+        for (; n + timeBlockLength <= numSamples; n += timeBlockLength)
+        {
+            const float* x = data + n;
+
+            //Two accumulators halve the chain of vector adds
+            auto y = Vector::fromRawArray(b.inputToOutput[0]) * x[0];
+            auto z = Vector::fromRawArray(b.inputToOutput[1]) * x[1];
+            float in1 = b.inputToState[0][0] * x[0] + b.inputToState[0][1] * x[1];
+            float in2 = b.inputToState[1][0] * x[0] + b.inputToState[1][1] * x[1];
+            for (int j = 2; j < timeBlockLength; j += 2)
+            {
+                y += Vector::fromRawArray(b.inputToOutput[j]) * x[j];
+                z += Vector::fromRawArray(b.inputToOutput[j + 1]) * x[j + 1];
+                in1 += b.inputToState[0][j] * x[j] + b.inputToState[0][j + 1] * x[j + 1];
+                in2 += b.inputToState[1][j] * x[j] + b.inputToState[1][j + 1] * x[j + 1];
+            }
+            y += Vector::fromRawArray(b.stateToOutput[0]) * lv1;
+            z += Vector::fromRawArray(b.stateToOutput[1]) * lv2;
+            y += z;
+
+            alignas(blockAlignment) float output[timeBlockLength];
+            y.copyToRawArray(output);
+            std::copy_n(output, timeBlockLength, data + n);
+
+            const float next1 = b.stateToState[0][0] * lv1 + b.stateToState[0][1] * lv2 + in1;
+            lv2 = b.stateToState[1][0] * lv1 + b.stateToState[1][1] * lv2 + in2;
+            lv1 = next1;
+        }
+       #endif
+
+        //Whatever doesn't fill a block runs through the recursion, which shares the same state
+        for (; n < numSamples; ++n)
+        {
+            const float input = data[n];
+            const float output = input * s.b0 + lv1;
+            lv1 = (input * s.b1) - (output * s.a1) + lv2;
+            lv2 = (input * s.b2) - (output * s.a2);
+            data[n] = output;
+        }
+
+        juce::dsp::util::snapToZero(lv1);
+        juce::dsp::util::snapToZero(lv2);
+        channelState[activeStateIndex[i]] = lv1;
+        channelState[activeStateIndex[i] + 1] = lv2;
+    }
+}
+
+void BiquadCascade::processChannels(float* const* channels, int startChannel, int endChannel, int numSamples) noexcept
+{
+    endChannel = juce::jmin(endChannel, numPreparedChannels);
+
+    for (int ch = startChannel; ch < endChannel; ++ch)
+    {
+        float* data = channels[ch];
+        float* channelState = state.data() + ch * statePerChannel;
+
+        if (timeBlocked)
+        {
+            processTimeBlocked(data, numSamples, channelState);
+            continue;
+        }
+
+        for (int first = 0; first < numActiveSections; first += maxFusedSections)
+        {
+            const Section* s = activeSections + first;
+            const int* stateIndex = activeStateIndex + first;
+            switch (juce::jmin(maxFusedSections, numActiveSections - first))
+            {
+            case 1: processFused<1>(data, numSamples, s, stateIndex, channelState); break;
+            case 2: processFused<2>(data, numSamples, s, stateIndex, channelState); break;
+            case 3: processFused<3>(data, numSamples, s, stateIndex, channelState); break;
+            case 4: processFused<4>(data, numSamples, s, stateIndex, channelState); break;
+            case 5: processFused<5>(data, numSamples, s, stateIndex, channelState); break;
+            case 6: processFused<6>(data, numSamples, s, stateIndex, channelState); break;
+            case 7: processFused<7>(data, numSamples, s, stateIndex, channelState); break;
+            case 8: processFused<8>(data, numSamples, s, stateIndex, channelState); break;
+            }
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.h
+    Created: 19 Oct 2026 1:55:21pm
+    Author:  jrgehrig
+
+    The band filters as one flat cascade of second order sections. Band
+    changes are staged and only resolved into the list of active sections
+    when the audio thread next calls process(), so a call with nothing
+    changed is a flag check and the filter loops themselves. Up to eight
+    sections are fused into each pass over the buffer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//The block sections are over-aligned members, and the processor that holds them is made with
+//new: only C++17's aligned new guarantees their alignment on the heap
+#if JUCE_USE_SIMD && ! defined (__cpp_aligned_new)
+ #error "BiquadCascade needs C++17 aligned new: set the project's C++ language standard to 17"
+#endif
+
+//==============================================================================
+/**
+*/
+class BiquadCascade
+{
+public:
+    static constexpr int maxBands = 4;
+
+    //A 96 dB/oct cut is eight second order sections
+    static constexpr int maxSectionsPerBand = 8;
+
+    BiquadCascade();
+
+    //Message thread, with audio stopped: sizes the filter state
+    void prepare(int numChannels);
+
+    //Audio thread
+    void reset() noexcept;
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+    //Split form of process() for processing channels in parallel: update() once on the audio
+    //thread, then processChannels() on disjoint channel ranges from any thread
+    void update() noexcept;
+    void processChannels(float* const* channels, int startChannel, int endChannel, int numSamples) noexcept;
+
+    //Audio thread: makes the calling thread the one whose writes skip the lock. update() does
+    //this as well, but a cascade that is written to before it is next updated needs it first.
+    void registerAudioThread() noexcept;
+
+    //Any thread, including several at once; the last write to a band wins. Never blocks when
+    //called on the audio thread. Each section is b0, b1, b2, a1, a2 normalised by a0, as in
+    //IIR::Coefficients; a band is one section for shelves and peaks, several for cuts.
+    //shape identifies the band's filter type and order: when it changes, the band's state
+    //starts from silence, since state left by one topology is meaningless to another.
+    void setBandSections(int band, const float (*coefficients)[5], int numSections, int shape = 0) noexcept;
+    void setBandBypassed(int band, bool bypassed) noexcept;
+
+    //Audio thread. Offline renders can swap the per sample recursion for a block state-space
+    //form that computes a SIMD register's worth of outputs per step from precomputed matrices.
+    //The matrices are only made while it is on, for the bands changed since they were last
+    //made, so realtime playback never pays for them. Not bit identical to the recursion;
+    //EngineValidator holds it to its own tolerance. Without SIMD support this does nothing.
+    void setTimeBlockedProcessing(bool shouldUseTimeBlocks) noexcept;
+
+private:
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int timeBlockLength = int(Vector::SIMDNumElements);
+    static constexpr size_t blockAlignment = sizeof(Vector);
+   #else
+    static constexpr int timeBlockLength = 4;
+    static constexpr size_t blockAlignment = alignof(float);
+   #endif
+
+    struct Section
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    //Sections processed in one pass over the buffer
+    static constexpr int maxFusedSections = 8;
+    static constexpr int maxSections = maxBands * maxSectionsPerBand;
+    static constexpr int statePerChannel = maxSections * 2;
+
+    //A section over timeBlockLength samples, with the TDF-II variables as the state:
+    //outputs = stateToOutput * state + inputToOutput * inputs
+    //state = stateToState * state + inputToState * inputs
+    //Every row of the output matrices is one aligned register.
+    struct alignas(blockAlignment) BlockSection
+    {
+        float inputToOutput[timeBlockLength][timeBlockLength];   //[input][output]
+        float stateToOutput[2][timeBlockLength];
+        float inputToState[2][timeBlockLength];
+        float stateToState[2][2];
+    };
+
+    //Band changes as written, each stamped from writeSequence so the latest write to a band
+    //wins whichever way it was staged
+    struct StagedBands
+    {
+        Section sections[maxBands][maxSectionsPerBand];
+        int numSections[maxBands];
+        int shape[maxBands];
+        bool bypassed[maxBands];
+        juce::uint32 sectionSequence[maxBands];
+        juce::uint32 bypassSequence[maxBands];
+    };
+
+    bool isAudioThread() const noexcept;
+    void mergePendingChanges() noexcept;
+    void applyStagedChanges() noexcept;
+    void updateBlockSections() noexcept;
+    static void makeBlockSection(const Section& section, BlockSection& block) noexcept;
+    void processTimeBlocked(float* data, int numSamples, float* channelState) noexcept;
+
+    template <int numFused>
+    static void processFused(float* data, int numSamples, const Section* sections, const int* stateIndex, float* channelState) noexcept;
+
+    //Writers on other threads hold the lock for a few stores and the audio thread only ever
+    //tries it, so a section can never be read half written. The audio thread, recognised as
+    //the thread that last registered itself, writes straight into its own copy instead.
+    juce::SpinLock pendingLock;
+    StagedBands pending;
+    std::atomic<bool> hasPendingChanges { false };
+    std::atomic<juce::uint32> writeSequence { 0 };
+    std::atomic<juce::Thread::ThreadID> audioThread { nullptr };
+
+    //Owned by the audio thread: the latest write to every band, and the sections of every
+    //active band in order, flattened
+    StagedBands staged;
+    bool hasStagedChanges = false;
+    Section activeSections[maxSections];
+    int activeStateIndex[maxSections];
+    int numActiveSections = 0;
+    int numSections[maxBands];
+    int shapes[maxBands];
+    juce::uint32 appliedSequence[maxBands] = {};
+
+    //Block sections at the same place as their state, band by band; a band's bit in
+    //staleBlockBands is set when its sections changed after its block sections were made
+    BlockSection blockSections[maxSections];
+    int staleBlockBands = (1 << maxBands) - 1;
+    bool timeBlocked = false;
+
+    //Two state variables per section per channel, kept even for bypassed bands
+    std::vector<float> state;
+    int numPreparedChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BiquadCascade)
+};
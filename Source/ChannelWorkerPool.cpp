@@ -0,0 +1,201 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.cpp
+    Created: 19 Oct 2026 3:21:47pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "ChannelWorkerPool.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    //Tells the core it is in a spin loop, so it doesn't starve a hyperthreaded sibling
+    inline void pauseWhileSpinning() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && JUCE_MSVC
+        __yield();
+       #elif JUCE_ARM
+        asm volatile ("yield");
+       #endif
+    }
+}
+
+ChannelWorkerPool::Worker::Worker(ChannelWorkerPool& owner, int index)
+    : juce::Thread("EQ channel worker " + juce::String(index)), pool(owner), workerIndex(index)
+{
+}
+
+void ChannelWorkerPool::Worker::wake() noexcept
+{
+    if (parked.load())
+        wakeEvent.signal();
+}
+
+void ChannelWorkerPool::Worker::run()
+{
+    const auto spinTicks = juce::int64(spinSeconds * double(juce::Time::getHighResolutionTicksPerSecond()));
+    int seenGeneration = pool.generation.load();
+
+    while (!threadShouldExit())
+    {
+        //Spin for a short while so back to back blocks don't pay for a wake-up, then park
+        const auto spinStart = juce::Time::getHighResolutionTicks();
+        while (pool.generation.load() == seenGeneration && !threadShouldExit())
+        {
+            if (juce::Time::getHighResolutionTicks() - spinStart < spinTicks)
+            {
+                pauseWhileSpinning();
+                continue;
+            }
+
+            //The generation is re-checked after publishing the parked flag, and run() checks
+            //the flag after bumping the generation, so one of the two always sees the other
+            parked = true;
+            if (pool.generation.load() == seenGeneration && !threadShouldExit())
+                wakeEvent.wait(100);
+            parked = false;
+        }
+
+        //Workers beyond what this block needs go straight back to waiting
+        seenGeneration = pool.generation.load();
+        if (workerIndex >= pool.numWorkersWanted.load())
+            continue;
+
+        while (pool.processNextGroup())
+        {
+        }
+    }
+}
+
+//==============================================================================
+ChannelWorkerPool::ChannelWorkerPool()
+    : ChannelWorkerPool(juce::SystemStats::getNumCpus() - 1)
+{
+}
+
+//JUCE's realtime audio priority: a time constraint policy on macOS, SCHED_RR where the user is
+//allowed it on Linux and time critical on Windows. It can't be told the host's block period.
+ChannelWorkerPool::ChannelWorkerPool(int numWorkers)
+    : lateWorkerTicks(juce::int64(lateWorkerSeconds * double(juce::Time::getHighResolutionTicksPerSecond())))
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this, i));
+        worker->startThread(juce::Thread::realtimeAudioPriority);
+    }
+}
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wakeEvent.signal();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+}
+
+int ChannelWorkerPool::getNumWorkers() const noexcept
+{
+    return workers.size();
+}
+
+bool ChannelWorkerPool::processNextGroup() noexcept
+{
+    auto counter = groupCounter.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const int group = int(counter & 0xffffffff);
+        const int numGroups = int(counter >> 32);
+        if (group >= numGroups)
+            return false;
+
+        if (groupCounter.compare_exchange_weak(counter, counter + 1, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            const int startChannel = group * currentChannelsPerGroup;
+            const int endChannel = juce::jmin(startChannel + currentChannelsPerGroup, currentNumChannels);
+            currentJob(currentContext, startChannel, endChannel);
+
+            groupsDone.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+void ChannelWorkerPool::run(Job job, void* context, int numChannels, int channelsPerGroup) noexcept
+{
+    const int numGroups = (numChannels + channelsPerGroup - 1) / channelsPerGroup;
+
+    auto processInline = [&]
+    {
+        for (int start = 0; start < numChannels; start += channelsPerGroup)
+            job(context, start, juce::jmin(start + channelsPerGroup, numChannels));
+    };
+
+    //Another instance has the workers: don't wait for them, do the work here
+    bool expected = false;
+    if (workers.isEmpty() || !busy.compare_exchange_strong(expected, true, std::memory_order_acquire))
+    {
+        processInline();
+        return;
+    }
+
+    //A worker kept a recent block waiting, so these ones don't count on the workers
+    if (inlineBlocksRemaining > 0)
+    {
+        --inlineBlocksRemaining;
+        busy.store(false, std::memory_order_release);
+        processInline();
+        return;
+    }
+
+    currentJob = job;
+    currentContext = context;
+    currentNumChannels = numChannels;
+    currentChannelsPerGroup = channelsPerGroup;
+    groupsDone.store(0, std::memory_order_relaxed);
+    groupCounter.store(juce::uint64(numGroups) << 32, std::memory_order_release);
+
+    const int numWanted = juce::jmin(workers.size(), numGroups - 1);
+    numWorkersWanted.store(numWanted, std::memory_order_relaxed);
+    ++generation;
+
+    for (int i = 0; i < numWanted; ++i)
+        workers.getUnchecked(i)->wake();
+
+    //Every group no worker has claimed yet is processed right here, so a worker that is slow
+    //to wake only ever costs the group it already holds
+    while (processNextGroup())
+    {
+    }
+
+    //Whatever is left is being filtered in place by a worker and can't be taken over, so it is
+    //waited for. Past the bound the worker has most likely been preempted: yield so it can run,
+    //and keep the next blocks inline.
+    const auto waitStart = juce::Time::getHighResolutionTicks();
+    while (groupsDone.load(std::memory_order_acquire) < numGroups)
+    {
+        if (juce::Time::getHighResolutionTicks() - waitStart < lateWorkerTicks)
+        {
+            pauseWhileSpinning();
+        }
+        else
+        {
+            inlineBlocksRemaining = inlineBlocksAfterLateWorker;
+            juce::Thread::yield();
+        }
+    }
+
+    busy.store(false, std::memory_order_release);
+}
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.h
+    Created: 19 Oct 2026 3:21:47pm
+    Author:  jrgehrig
+
+    Persistent worker threads that help the audio thread filter groups of
+    channels. Groups are claimed through an atomic counter, and the audio
+    thread works on groups itself before spinning until the last one is
+    done, so run() returns with every channel processed. A worker that
+    keeps the audio thread waiting too long is left out for a while, and
+    those blocks are processed inline.
+
+    One pool serves every instance in the process, through a
+    juce::SharedResourcePointer, so a session full of instances doesn't
+    start a set of threads each. It serves one run() at a time; an
+    instance that finds it busy processes its channels inline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class ChannelWorkerPool
+{
+public:
+    //Processes channels [startChannel, endChannel). Called concurrently for disjoint ranges.
+    using Job = void (*)(void* context, int startChannel, int endChannel);
+
+    //One worker per core, leaving a core for the audio thread
+    ChannelWorkerPool();
+    explicit ChannelWorkerPool(int numWorkers);
+    ~ChannelWorkerPool();
+
+    //Audio thread. No locks or allocation; blocks until all groups have been processed. Wakes
+    //no more workers than there are groups beyond the caller's own.
+    void run(Job job, void* context, int numChannels, int channelsPerGroup) noexcept;
+
+    int getNumWorkers() const noexcept;
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(ChannelWorkerPool& owner, int index);
+        void run() override;
+        void wake() noexcept;
+
+    private:
+        ChannelWorkerPool& pool;
+        const int workerIndex;
+        juce::WaitableEvent wakeEvent;
+        std::atomic<bool> parked { false };
+
+        friend class ChannelWorkerPool;
+    };
+
+    bool processNextGroup() noexcept;
+
+    //How long an idle worker spins for the next block before parking on its event
+    static constexpr double spinSeconds = 0.0002;
+
+    //How long the audio thread spins on a group a worker holds before it yields its core, in
+    //case the worker was preempted there, and how many blocks it then processes inline
+    static constexpr double lateWorkerSeconds = 0.0001;
+    static constexpr int inlineBlocksAfterLateWorker = 256;
+
+    //Held for the whole of a run(), so instances sharing the pool never mix their groups
+    std::atomic<bool> busy { false };
+    std::atomic<int> generation { 0 };
+    std::atomic<int> numWorkersWanted { 0 };
+
+    //Group count in the high 32 bits, next unclaimed group in the low 32, so a claim can
+    //never succeed against another block's count
+    std::atomic<juce::uint64> groupCounter { 0 };
+    std::atomic<int> groupsDone { 0 };
+    const juce::int64 lateWorkerTicks;
+
+    //Only touched by the holder of busy
+    int inlineBlocksRemaining = 0;
+
+    //Only written by run() while no group of the previous block can still be claimed
+    Job currentJob = nullptr;
+    void* currentContext = nullptr;
+    int currentNumChannels = 0;
+    int currentChannelsPerGroup = 1;
+
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelWorkerPool)
+};
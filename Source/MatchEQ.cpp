@@ -0,0 +1,493 @@
+/*
+  ==============================================================================
+
+    MatchEQ.cpp
+    Created: 19 Oct 2026 4:48:12pm
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "MatchEQ.h"
+#include "TraceRecorder.h"
+
+MatchEQ::LongTermSpectrum::LongTermSpectrum()
+    : fft(fftOrder), window(size_t(fftSize), juce::dsp::WindowingFunction<float>::hann, false)
+{
+    frame.resize(size_t(fftSize));
+    fftData.resize(size_t(fftSize * 2));
+    reset(sampleRate);
+}
+
+void MatchEQ::LongTermSpectrum::reset(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    powerSum.assign(size_t(fftSize / 2 + 1), 0.0);
+    frameFill = 0;
+    numFrames = 0;
+}
+
+bool MatchEQ::LongTermSpectrum::isEmpty() const noexcept
+{
+    return numFrames == 0;
+}
+
+void MatchEQ::LongTermSpectrum::addSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        const int toCopy = juce::jmin(numSamples, fftSize - frameFill);
+        std::copy(samples, samples + toCopy, frame.begin() + frameFill);
+        frameFill += toCopy;
+        samples += toCopy;
+        numSamples -= toCopy;
+
+        if (frameFill < fftSize)
+            break;
+
+        std::copy(frame.begin(), frame.end(), fftData.begin());
+        window.multiplyWithWindowingTable(fftData.data(), size_t(fftSize));
+        fft.performFrequencyOnlyForwardTransform(fftData.data());
+        for (size_t k = 0; k < powerSum.size(); ++k)
+            powerSum[k] += double(fftData[k]) * double(fftData[k]);
+        ++numFrames;
+
+        //Half overlap: the second half of this frame starts the next one
+        std::copy(frame.begin() + fftSize / 2, frame.end(), frame.begin());
+        frameFill = fftSize / 2;
+    }
+}
+
+void MatchEQ::LongTermSpectrum::getLevelsDB(const double* frequencies, double* levels, int numFrequencies) const
+{
+    const double binsPerHz = fftSize / sampleRate;
+    const int lastBin = fftSize / 2;
+    const double bandEdge = std::pow(2.0, 1.0 / 6.0);
+
+    for (int i = 0; i < numFrequencies; ++i)
+    {
+        int lowBin = juce::jlimit(1, lastBin, int(std::ceil(frequencies[i] / bandEdge * binsPerHz)));
+        int highBin = juce::jlimit(1, lastBin, int(std::floor(frequencies[i] * bandEdge * binsPerHz)));
+
+        //Low frequencies can fall between bins; use the nearest one
+        if (highBin < lowBin)
+            lowBin = highBin = juce::jlimit(1, lastBin, juce::roundToInt(frequencies[i] * binsPerHz));
+
+        double power = 0.0;
+        for (int k = lowBin; k <= highBin; ++k)
+            power += powerSum[size_t(k)];
+        power /= double(highBin - lowBin + 1) * double(juce::jmax(1, numFrames));
+
+        levels[i] = 10.0 * std::log10(power + 1.0e-20);
+    }
+}
+
+//==============================================================================
+MatchEQ::MatchEQ()
+    : juce::Thread("EQ match analysis")
+{
+    numIslands = juce::jlimit(1, 8, juce::SystemStats::getNumCpus() - 1);
+}
+
+MatchEQ::~MatchEQ()
+{
+    cancelJobs = true;
+    pool.reset();
+    stopThread(1000);
+    cancelPendingUpdate();
+}
+
+juce::ThreadPool& MatchEQ::getPool()
+{
+    if (pool == nullptr)
+        pool = std::make_unique<juce::ThreadPool>(numIslands);
+    return *pool;
+}
+
+void MatchEQ::prepare(double sampleRate)
+{
+    const juce::ScopedLock sl(spectrumLock);
+    if (sampleRate != targetSampleRate)
+    {
+        targetSampleRate = sampleRate;
+        if (target != nullptr)
+            target->reset(sampleRate);
+    }
+}
+
+void MatchEQ::analyseReference(const juce::File& file)
+{
+    //Every request gets a token. A newer request supersedes the ones still running: they stop
+    //at their next block and never publish, so the last file asked for is the one that counts.
+    const int job = ++referenceJob;
+    analysingReference = true;
+    getPool().addJob([this, file, job]
+    {
+        PARAMETRICEQ_TRACE_SCOPE("match analyse reference");
+        auto isSuperseded = [this, job] { return cancelJobs || referenceJob != job; };
+
+        //Analysed privately and swapped in whole, under the lock, only if still current
+        std::unique_ptr<LongTermSpectrum> spectrum;
+        auto publish = [this, job, &spectrum]
+        {
+            const juce::ScopedLock sl(spectrumLock);
+            if (referenceJob != job)
+                return;
+            if (spectrum != nullptr)
+                reference = std::move(spectrum);
+            analysingReference = false;
+        };
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+        if (reader == nullptr)
+        {
+            publish();
+            return;
+        }
+
+        const int blockSize = 8192;
+        const int numChannels = juce::jmax(1, int(reader->numChannels));
+        juce::AudioBuffer<float> block(numChannels, blockSize);
+        std::vector<float> mono(size_t(blockSize));
+
+        spectrum = std::make_unique<LongTermSpectrum>();
+        spectrum->reset(reader->sampleRate);
+
+        for (juce::int64 position = 0; position < reader->lengthInSamples; position += blockSize)
+        {
+            if (isSuperseded())
+                return;
+
+            const int length = int(juce::jmin(juce::int64(blockSize), reader->lengthInSamples - position));
+            reader->read(&block, 0, length, position, true, true);
+
+            juce::FloatVectorOperations::copy(mono.data(), block.getReadPointer(0), length);
+            for (int ch = 1; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::add(mono.data(), block.getReadPointer(ch), length);
+            juce::FloatVectorOperations::multiply(mono.data(), 1.0f / float(numChannels), length);
+
+            spectrum->addSamples(mono.data(), length);
+        }
+        publish();
+    });
+}
+
+bool MatchEQ::hasReference() const
+{
+    const juce::ScopedLock sl(spectrumLock);
+    return !analysingReference && reference != nullptr && !reference->isEmpty();
+}
+
+bool MatchEQ::hasTarget() const
+{
+    const juce::ScopedLock sl(spectrumLock);
+    return target != nullptr && !target->isEmpty();
+}
+
+void MatchEQ::clearTarget()
+{
+    const juce::ScopedLock sl(spectrumLock);
+    if (target != nullptr)
+        target->reset(targetSampleRate);
+}
+
+//==============================================================================
+void MatchEQ::setLearning(bool shouldLearn)
+{
+    //The analysis buffers and thread only exist once learning has been asked for
+    if (shouldLearn && targetBuffer.empty())
+    {
+        targetBuffer.resize(size_t(targetFifo.getTotalSize()));
+        const juce::ScopedLock sl(spectrumLock);
+        target = std::make_unique<LongTermSpectrum>();
+        target->reset(targetSampleRate);
+    }
+    if (shouldLearn && !isThreadRunning())
+        startThread();
+    learning = shouldLearn;
+}
+
+bool MatchEQ::isLearning() const noexcept
+{
+    return learning;
+}
+
+void MatchEQ::pushSamples(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    const int numChannels = buffer.getNumChannels();
+    if (!learning.load(std::memory_order_acquire) || numChannels == 0)
+        return;
+
+    //Whatever doesn't fit is dropped; the average doesn't need every block
+    int start1, size1, start2, size2;
+    targetFifo.prepareToWrite(buffer.getNumSamples(), start1, size1, start2, size2);
+
+    const float scale = 1.0f / float(numChannels);
+    auto mixInto = [&](int start, int size, int sourceOffset)
+    {
+        float* dest = targetBuffer.data() + start;
+        juce::FloatVectorOperations::copyWithMultiply(dest, buffer.getReadPointer(0, sourceOffset), scale, size);
+        for (int ch = 1; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply(dest, buffer.getReadPointer(ch, sourceOffset), scale, size);
+    };
+
+    if (size1 > 0)
+        mixInto(start1, size1, 0);
+    if (size2 > 0)
+        mixInto(start2, size2, size1);
+    targetFifo.finishedWrite(size1 + size2);
+}
+
+void MatchEQ::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(20);
+        drainTarget();
+    }
+}
+
+void MatchEQ::drainTarget()
+{
+    int start1, size1, start2, size2;
+    targetFifo.prepareToRead(targetFifo.getNumReady(), start1, size1, start2, size2);
+    if (size1 + size2 == 0)
+        return;
+
+    {
+        const juce::ScopedLock sl(spectrumLock);
+        target->addSamples(targetBuffer.data() + start1, size1);
+        target->addSamples(targetBuffer.data() + start2, size2);
+    }
+    targetFifo.finishedRead(size1 + size2);
+}
+
+//==============================================================================
+bool MatchEQ::isFitting() const noexcept
+{
+    return islandsRemaining > 0;
+}
+
+bool MatchEQ::startFit(const BandRange* ranges, double sampleRate)
+{
+    if (isFitting())
+        return false;
+
+    for (int b = 0; b < numBands; ++b)
+        problem.ranges[b] = ranges[b];
+    problem.sampleRate = sampleRate;
+
+    //Log spaced grid, stopping short of Nyquist at low sample rates
+    const double highest = juce::jmin(20000.0, sampleRate * 0.45);
+    const int numPoints = int(std::log2(highest / 20.0) * fitPointsPerOctave) + 1;
+    problem.frequencies.resize(size_t(numPoints));
+    for (int i = 0; i < numPoints; ++i)
+        problem.frequencies[size_t(i)] = 20.0 * std::pow(2.0, double(i) / fitPointsPerOctave);
+
+    std::vector<double> referenceDB(size_t(numPoints)), targetLevelsDB(size_t(numPoints));
+    {
+        const juce::ScopedLock sl(spectrumLock);
+        if (analysingReference || reference == nullptr || target == nullptr || reference->isEmpty() || target->isEmpty())
+            return false;
+        reference->getLevelsDB(problem.frequencies.data(), referenceDB.data(), numPoints);
+        target->getLevelsDB(problem.frequencies.data(), targetLevelsDB.data(), numPoints);
+    }
+
+    //Levels differ between any two recordings; only the shape of the difference is matched,
+    //so its average between 100 Hz and 8 kHz is taken out
+    double offset = 0.0;
+    int numInRange = 0;
+    for (int i = 0; i < numPoints; ++i)
+    {
+        if (problem.frequencies[size_t(i)] >= 100.0 && problem.frequencies[size_t(i)] <= 8000.0)
+        {
+            offset += referenceDB[size_t(i)] - targetLevelsDB[size_t(i)];
+            ++numInRange;
+        }
+    }
+    offset /= juce::jmax(1, numInRange);
+
+    problem.targetDB.resize(size_t(numPoints));
+    problem.cosW.resize(size_t(numPoints));
+    problem.cos2W.resize(size_t(numPoints));
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const double difference = referenceDB[size_t(i)] - targetLevelsDB[size_t(i)] - offset;
+        const double w = juce::MathConstants<double>::twoPi * problem.frequencies[size_t(i)] / sampleRate;
+        problem.targetDB[size_t(i)] = float(juce::jlimit(-24.0, 24.0, difference));
+        problem.cosW[size_t(i)] = float(std::cos(w));
+        problem.cos2W[size_t(i)] = float(std::cos(2.0 * w));
+    }
+
+    {
+        const juce::ScopedLock sl(resultLock);
+        bestResult = {};
+        bestResult.rmsErrorDB = std::numeric_limits<double>::max();
+    }
+
+    fitStartTicks = juce::Time::getHighResolutionTicks();
+    islandsRemaining = numIslands;
+    for (int island = 0; island < numIslands; ++island)
+        getPool().addJob([this, island] { runIsland(island); });
+    return true;
+}
+
+void MatchEQ::evaluateBatch(const Candidate* candidates, double* errors, int numCandidates, std::vector<float>& scratch) const
+{
+    //Every band's power response in closed form: |B(w)|^2 / |A(w)|^2, with
+    //|b0 + b1 z^-1 + b2 z^-2|^2 = b0^2 + b1^2 + b2^2 + 2 (b0 b1 + b1 b2) cos w + 2 b0 b2 cos 2w.
+    //The inner loops are branch free over the grid so they vectorise.
+    const int numPoints = int(problem.targetDB.size());
+    const float* cosW = problem.cosW.data();
+    const float* cos2W = problem.cos2W.data();
+    const float* targetDB = problem.targetDB.data();
+    scratch.resize(size_t(numPoints));
+    float* power = scratch.data();
+
+    for (int c = 0; c < numCandidates; ++c)
+    {
+        std::fill(power, power + numPoints, 1.0f);
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            const auto& range = problem.ranges[b];
+            const double cutoff = range.cutoff.convertFrom0to1(candidates[c].values[b * 3]);
+            const double q = range.q.convertFrom0to1(candidates[c].values[b * 3 + 1]);
+            const double gain = juce::Decibels::decibelsToGain(double(range.gainDB.convertFrom0to1(candidates[c].values[b * 3 + 2])));
+
+            std::array<double, 6> k;
+            switch (range.shape)
+            {
+            case Shape::lowShelf: k = juce::dsp::IIR::ArrayCoefficients<double>::makeLowShelf(problem.sampleRate, cutoff, q, gain); break;
+            case Shape::highShelf: k = juce::dsp::IIR::ArrayCoefficients<double>::makeHighShelf(problem.sampleRate, cutoff, q, gain); break;
+            case Shape::peak: k = juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(problem.sampleRate, cutoff, q, gain); break;
+            }
+
+            const float n0 = float(k[0] * k[0] + k[1] * k[1] + k[2] * k[2]);
+            const float n1 = float(2.0 * (k[0] * k[1] + k[1] * k[2]));
+            const float n2 = float(2.0 * k[0] * k[2]);
+            const float d0 = float(k[3] * k[3] + k[4] * k[4] + k[5] * k[5]);
+            const float d1 = float(2.0 * (k[3] * k[4] + k[4] * k[5]));
+            const float d2 = float(2.0 * k[3] * k[5]);
+
+            for (int i = 0; i < numPoints; ++i)
+                power[i] *= (n0 + n1 * cosW[i] + n2 * cos2W[i]) / (d0 + d1 * cosW[i] + d2 * cos2W[i]);
+        }
+
+        double sumOfSquares = 0.0;
+        for (int i = 0; i < numPoints; ++i)
+        {
+            //Floored like the spectrum levels, so a deep notch can't make the error infinite
+            const float error = 10.0f * std::log10(juce::jmax(power[i], 1.0e-20f)) - targetDB[i];
+            sumOfSquares += double(error * error);
+        }
+        errors[c] = std::sqrt(sumOfSquares / juce::jmax(1, numPoints));
+    }
+}
+
+void MatchEQ::runIsland(int island)
+{
+    PARAMETRICEQ_TRACE_SCOPE("match fit island");
+
+    //Differential evolution (rand/1/bin). Each island runs its own population from its own
+    //seed, so the threads never wait on each other; the best island wins.
+    juce::Random random(0x6d61746368 + island);
+    std::vector<Candidate> population(populationSize), trials(populationSize);
+    std::vector<double> errors(populationSize), trialErrors(populationSize);
+    std::vector<float> scratch;
+
+    for (auto& candidate : population)
+        for (auto& value : candidate.values)
+            value = random.nextFloat();
+
+    evaluateBatch(population.data(), errors.data(), populationSize, scratch);
+
+    const double crossover = 0.9;
+    double bestError = *std::min_element(errors.begin(), errors.end());
+    double lastImprovement = bestError;
+    int generationsWithoutImprovement = 0;
+
+    for (int generation = 0; generation < maxGenerations && !cancelJobs; ++generation)
+    {
+        const float scale = 0.5f + 0.4f * random.nextFloat();
+        for (int i = 0; i < populationSize; ++i)
+        {
+            int a, b, c;
+            do { a = random.nextInt(populationSize); } while (a == i);
+            do { b = random.nextInt(populationSize); } while (b == i || b == a);
+            do { c = random.nextInt(populationSize); } while (c == i || c == a || c == b);
+
+            const int forced = random.nextInt(numFitParameters);
+            for (int p = 0; p < numFitParameters; ++p)
+            {
+                const float mutated = population[size_t(a)].values[p] + scale * (population[size_t(b)].values[p] - population[size_t(c)].values[p]);
+                trials[size_t(i)].values[p] = (p == forced || random.nextDouble() < crossover) ? juce::jlimit(0.0f, 1.0f, mutated)
+                                                                                                : population[size_t(i)].values[p];
+            }
+        }
+
+        evaluateBatch(trials.data(), trialErrors.data(), populationSize, scratch);
+
+        for (size_t i = 0; i < size_t(populationSize); ++i)
+        {
+            if (trialErrors[i] <= errors[i])
+            {
+                population[i] = trials[i];
+                errors[i] = trialErrors[i];
+                bestError = juce::jmin(bestError, errors[i]);
+            }
+        }
+
+        //Converged once the best candidate stops improving by a meaningful amount
+        if (lastImprovement - bestError > 0.001)
+        {
+            lastImprovement = bestError;
+            generationsWithoutImprovement = 0;
+        }
+        else if (++generationsWithoutImprovement > 60)
+        {
+            break;
+        }
+    }
+
+    const auto best = size_t(std::min_element(errors.begin(), errors.end()) - errors.begin());
+    {
+        const juce::ScopedLock sl(resultLock);
+        if (errors[best] < bestResult.rmsErrorDB)
+            bestResult = toResult(population[best], errors[best]);
+    }
+
+    if (--islandsRemaining == 0)
+    {
+        const juce::ScopedLock sl(resultLock);
+        bestResult.fitSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - fitStartTicks);
+        triggerAsyncUpdate();
+    }
+}
+
+MatchEQ::Result MatchEQ::toResult(const Candidate& candidate, double error) const
+{
+    Result result;
+    for (int b = 0; b < numBands; ++b)
+    {
+        result.cutoff[b] = problem.ranges[b].cutoff.convertFrom0to1(candidate.values[b * 3]);
+        result.q[b] = problem.ranges[b].q.convertFrom0to1(candidate.values[b * 3 + 1]);
+        result.gainDB[b] = problem.ranges[b].gainDB.convertFrom0to1(candidate.values[b * 3 + 2]);
+    }
+    result.rmsErrorDB = error;
+    return result;
+}
+
+void MatchEQ::handleAsyncUpdate()
+{
+    Result result;
+    {
+        const juce::ScopedLock sl(resultLock);
+        result = bestResult;
+    }
+
+    if (onFitFinished != nullptr && !cancelJobs)
+        onFitFinished(result);
+}
@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    MatchEQ.h
+    Created: 19 Oct 2026 4:48:12pm
+    Author:  jrgehrig
+
+    Matches the bands to a reference. Long-term average spectra of a
+    reference file and of the plugin's input are collected in the
+    background, and the band settings are fitted to the difference between
+    them by a differential evolution search running on several threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class MatchEQ : private juce::Thread, private juce::AsyncUpdater
+{
+public:
+    static constexpr int numBands = 4;
+
+    //Band shapes, in the same order as the processor's bands
+    enum class Shape { lowShelf, peak, highShelf };
+
+    struct BandRange
+    {
+        Shape shape;
+        juce::NormalisableRange<float> cutoff;
+        juce::NormalisableRange<float> q;
+        juce::NormalisableRange<float> gainDB;
+    };
+
+    struct Result
+    {
+        float cutoff[numBands];
+        float q[numBands];
+        float gainDB[numBands];
+        double rmsErrorDB;
+        double fitSeconds = 0.0;
+    };
+
+    MatchEQ();
+    ~MatchEQ() override;
+
+    //Message thread. A new reference replaces one still being analysed.
+    void prepare(double sampleRate);
+    void analyseReference(const juce::File& file);
+    void setLearning(bool shouldLearn);
+    bool isLearning() const noexcept;
+    bool hasReference() const;
+    bool hasTarget() const;
+    void clearTarget();
+
+    //Fits the bands to the difference between the reference and the learnt target spectrum.
+    //Returns false if either is missing or a fit is already running; otherwise onFitFinished is
+    //called on the message thread when it is done.
+    bool startFit(const BandRange* ranges, double sampleRate);
+    bool isFitting() const noexcept;
+    std::function<void(const Result&)> onFitFinished;
+
+    //Audio thread: copies a mono mix of the buffer for the target spectrum while learning
+    void pushSamples(const juce::AudioBuffer<float>& buffer) noexcept;
+
+private:
+    //Power spectrum averaged over every Hann windowed, half overlapping frame seen so far
+    class LongTermSpectrum
+    {
+    public:
+        LongTermSpectrum();
+        void reset(double newSampleRate);
+        void addSamples(const float* samples, int numSamples);
+        bool isEmpty() const noexcept;
+
+        //Averaged over a third of an octave around each frequency, in dB
+        void getLevelsDB(const double* frequencies, double* levels, int numFrequencies) const;
+
+    private:
+        static constexpr int fftOrder = 13;
+        static constexpr int fftSize = 1 << fftOrder;
+
+        juce::dsp::FFT fft;
+        juce::dsp::WindowingFunction<float> window;
+        std::vector<float> frame;
+        std::vector<float> fftData;
+        std::vector<double> powerSum;
+        int frameFill = 0;
+        int numFrames = 0;
+        double sampleRate = 44100.0;
+    };
+
+    //Band candidates are normalised to 0..1 per parameter and mapped through the parameter ranges
+    static constexpr int numFitParameters = numBands * 3;
+    static constexpr int populationSize = 40;
+    static constexpr int maxGenerations = 400;
+    static constexpr int fitPointsPerOctave = 48;
+
+    struct FitProblem
+    {
+        BandRange ranges[numBands];
+        std::vector<double> frequencies;
+        std::vector<float> targetDB;
+        std::vector<float> cosW;
+        std::vector<float> cos2W;
+        double sampleRate;
+    };
+
+    struct Candidate
+    {
+        float values[numFitParameters];
+    };
+
+    void runIsland(int island);
+    void evaluateBatch(const Candidate* candidates, double* errors, int numCandidates, std::vector<float>& scratch) const;
+    Result toResult(const Candidate& candidate, double error) const;
+    void run() override;
+    void drainTarget();
+    void handleAsyncUpdate() override;
+    juce::ThreadPool& getPool();
+
+    //Created on first use; most instances never match anything
+    juce::CriticalSection spectrumLock;
+    std::unique_ptr<LongTermSpectrum> reference;
+    std::unique_ptr<LongTermSpectrum> target;
+    double targetSampleRate = 44100.0;
+    std::atomic<bool> analysingReference { false };
+    std::atomic<int> referenceJob { 0 };
+
+    //Audio thread to analysis thread
+    juce::AbstractFifo targetFifo { 1 << 17 };
+    std::vector<float> targetBuffer;
+    std::atomic<bool> learning { false };
+
+    FitProblem problem;
+    int numIslands = 1;
+    std::atomic<int> islandsRemaining { 0 };
+    juce::int64 fitStartTicks = 0;
+    std::atomic<bool> cancelJobs { false };
+    juce::CriticalSection resultLock;
+    Result bestResult;
+
+    //Created on first use and destroyed first, so its jobs never outlive the state above
+    std::unique_ptr<juce::ThreadPool> pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MatchEQ)
+};
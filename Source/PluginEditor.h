@@ -1,98 +1,127 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-    
-    Filter ranges:
-    Low 40 - 600
-    LM  200 - 2k
-    HM  600 - 7k
-    High 1.5k - 22k
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-//==============================================================================
-/**
-*/
-class ParametricEQAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::ChangeListener
-{
-public:
-    ParametricEQAudioProcessorEditor (ParametricEQAudioProcessor&);
-    ~ParametricEQAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint (juce::Graphics&) override;
-    void resized() override;
-    float getFrequencyForPosition(float pos);
-    void changeListenerCallback(juce::ChangeBroadcaster* sender) override;
-    
-    class FilterEditor : public juce::GroupComponent
-    {
-    public:
-        FilterEditor(ParametricEQAudioProcessor&, int);
-        ~FilterEditor();
-        void resized() override; 
-        
-        void setSliderAttachments(int index);
-        void setButtonAttachments(int index); 
-
-        juce::Slider* getCutoffDial();
-        juce::Label* getCutoffLabel();
-
-        juce::Slider* getGainDial();
-        juce::Label* getGainLabel();
-
-        juce::Slider* getQDial();
-        juce::Label* getQLabel();
-
-        juce::TextButton* getActiveSwitch();
-
-        juce::Path filterResponse;
-        juce::Colour filterResponseColour;
-
-    private:
-        juce::Slider cutoffDial;
-        juce::Label cutoffLabel;
-
-        juce::Slider gainDial;
-        juce::Label gainLabel;
-
-        juce::Slider qDial;
-        juce::Label qLabel;
-
-        juce::TextButton activeSwitch;
-
-        ParametricEQAudioProcessor& filterEditorProcessor;
-        int index; 
-
-        juce::OwnedArray<juce::AudioProcessorValueTreeState::SliderAttachment> filterSliderAttachments;
-        std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> activeAttachment;
-
-
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterEditor)
-    };
-
-    void genFilter(FilterEditor&);
-    
-    void setButtonAttachments(juce::OwnedArray<juce::AudioProcessorValueTreeState::ButtonAttachment>&, FilterEditor&, int index);
-    
-private:
-    ParametricEQAudioProcessor& audioProcessor;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEQAudioProcessorEditor);
-
-    void updateFrequencyResponses();
-
-    juce::Rectangle<int> plotFrame;
-
-    juce::Path totalResponse;
-
-    juce::OwnedArray<FilterEditor> bands;   
-
-    juce::SharedResourcePointer<juce::TooltipWindow> tooltipWindow;
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+    
+    Filter ranges:
+    Low 40 - 600
+    LM  200 - 2k
+    HM  600 - 7k
+    High 1.5k - 22k
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/**
+*/
+class ParametricEQAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::ChangeListener
+{
+public:
+    ParametricEQAudioProcessorEditor (ParametricEQAudioProcessor&);
+    ~ParametricEQAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+    float getFrequencyForPosition(float pos);
+    void changeListenerCallback(juce::ChangeBroadcaster* sender) override;
+    
+    class FilterEditor : public juce::GroupComponent
+    {
+    public:
+        FilterEditor(ParametricEQAudioProcessor&, int);
+        ~FilterEditor();
+        void resized() override; 
+        
+        void setSliderAttachments(int index);
+        void setButtonAttachments(int index); 
+        void setComboBoxAttachments(int index);
+        void updateDialsEnabled();
+
+        juce::Slider* getCutoffDial();
+        juce::Label* getCutoffLabel();
+
+        juce::Slider* getGainDial();
+        juce::Label* getGainLabel();
+
+        juce::Slider* getQDial();
+        juce::Label* getQLabel();
+
+        juce::TextButton* getActiveSwitch();
+
+        juce::Path filterResponse;
+        juce::Colour filterResponseColour;
+
+    private:
+        juce::Slider cutoffDial;
+        juce::Label cutoffLabel;
+
+        juce::Slider gainDial;
+        juce::Label gainLabel;
+
+        juce::Slider qDial;
+        juce::Label qLabel;
+
+        juce::TextButton activeSwitch;
+
+        //End bands only: shelf or cut, and the cut's slope
+        juce::ComboBox typeBox;
+        juce::ComboBox slopeBox;
+
+        ParametricEQAudioProcessor& filterEditorProcessor;
+        int index; 
+
+        juce::OwnedArray<juce::AudioProcessorValueTreeState::SliderAttachment> filterSliderAttachments;
+        std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> activeAttachment;
+        std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> typeAttachment;
+        std::unique_ptr <juce::AudioProcessorValueTreeState::ComboBoxAttachment> slopeAttachment;
+
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterEditor)
+    };
+
+    void genFilter(FilterEditor&);
+    
+    void setButtonAttachments(juce::OwnedArray<juce::AudioProcessorValueTreeState::ButtonAttachment>&, FilterEditor&, int index);
+    
+private:
+    ParametricEQAudioProcessor& audioProcessor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEQAudioProcessorEditor);
+
+    void updateFrequencyResponses();
+
+    juce::Rectangle<int> plotFrame;
+
+    juce::Path totalResponse;
+
+    juce::OwnedArray<FilterEditor> bands;   
+
+    //Built with their attachments the first time the editor is shown, so an editor a host only
+    //creates doesn't pay for sixteen controls bound to the parameters
+    void createBandEditors();
+
+    //Subscribed only while the editor is visible on a window: one that is created but never
+    //shown costs no plot work
+    bool subscribedToPlots = false;
+    void updatePlotSubscription();
+
+    //Match EQ controls under the plot
+    juce::TextButton referenceButton;
+    juce::TextButton learnButton;
+    juce::TextButton matchButton;
+    std::unique_ptr<juce::FileChooser> referenceChooser;
+
+    void chooseReference();
+    void startMatch();
+    void updateMatchButton();
+
+    juce::SharedResourcePointer<juce::TooltipWindow> tooltipWindow;
+};
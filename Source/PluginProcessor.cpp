@@ -1,544 +1,1654 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-juce::String ParametricEQAudioProcessor::getFilterCutoffParamName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0Cutoff"; break;
-    case 1: return "Band1Cutoff"; break; 
-    case 2: return "Band2Cutoff"; break;
-    case 3: return "Band3Cutoff"; break;
-    }
-    return "invalid";
-}
-
-juce::String ParametricEQAudioProcessor::getFilterQParamName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0Q"; break;
-    case 1: return "Band1Q"; break;
-    case 2: return "Band2Q"; break;
-    case 3: return "Band3Q"; break;
-    }
-    return "invalid";
-}
-
-juce::String ParametricEQAudioProcessor::getFilterGainParamName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0Gain"; break;
-    case 1: return "Band1Gain"; break;
-    case 2: return "Band2Gain"; break;
-    case 3: return "Band3Gain"; break;
-    }
-    return "invalid";
-}
-
-juce::String ParametricEQAudioProcessor::getFilterBandNum(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0"; break;
-    case 1: return "Band1"; break;
-    case 2: return "Band2"; break;
-    case 3: return "Band3"; break;
-    }
-    return "invalid";
-}
-
-juce::String ParametricEQAudioProcessor::getFilterBandName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Low Shelf"; break;
-    case 1: return "Param 1"; break;
-    case 2: return "Param 2"; break;
-    case 3: return "High Shelf"; break;
-    }
-    return "invalid";
-}
-
-juce::String ParametricEQAudioProcessor::getFilterMagnitudeName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0Magnitude"; break;
-    case 1: return "Band1Magnitude"; break;
-    case 2: return "Band2Magnitude"; break;
-    case 3: return "Band3Magnitude"; break;
-    }
-    return "invalid";
-}
-
-juce::String ParametricEQAudioProcessor::getFilterActiveName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0Active"; break;
-    case 1: return "Band1Active"; break;
-    case 2: return "Band2Active"; break;
-    case 3: return "Band3Active"; break;
-    }
-    return "invalid";
-}
-juce::String ParametricEQAudioProcessor::getFilterSoloName(int index)
-{
-    switch (index)
-    {
-    case 0: return "Band0Solo"; break;
-    case 1: return "Band1Solo"; break;
-    case 2: return "Band2Solo"; break;
-    case 3: return "Band3Solo"; break;
-    }
-    return "invalid";
-}
-
-int ParametricEQAudioProcessor::getBandIndexFromID(juce::String paramID)
-{
-    for (int i = 0; i < 4; ++i)
-        if (paramID.startsWith(getFilterBandNum(i)))
-        {
-            return int(i);
-        }
-    return -1;
-}
-
-//==============================================================================
-ParametricEQAudioProcessor::ParametricEQAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ), tree(*this, nullptr, "PARAMS", createParameterLayout()), lastSampleRate(44100.0f)
-
-#endif
-{
-    frequencies.resize(300);
-    for (int i = 0; i < frequencies.size(); ++i) {
-        frequencies[i] = 20.0 * std::pow(2.0, i / 30.0);
-    } 
-    magnitudes.resize(frequencies.size());
-    lowShelfMagnitudes.resize(frequencies.size());
-    lowMidsMagnitudes.resize(frequencies.size());
-    highMidsMagnitudes.resize(frequencies.size());
-    highShelfMagnitudes.resize(frequencies.size());
-
-    *filterChain.get<0>().state = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(44100, 134.2f, 0.62f, 1.0f);
-    *filterChain.get<1>().state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(44100, 883.9f, 5.7f, 1.0f);
-    *filterChain.get<2>().state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(44100, 883.9f, 5.7f, 1.0f);
-    *filterChain.get<3>().state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(44100, 6000.0f, 0.62f, 1.0f);
-    
-    filterChain.get<0>().state->getMagnitudeForFrequencyArray(frequencies.data(),
-        lowShelfMagnitudes.data(),
-        frequencies.size(), lastSampleRate);
-    filterChain.get<1>().state->getMagnitudeForFrequencyArray(frequencies.data(),
-        lowMidsMagnitudes.data(),
-        frequencies.size(), lastSampleRate);
-    filterChain.get<2>().state->getMagnitudeForFrequencyArray(frequencies.data(),
-        highMidsMagnitudes.data(),
-        frequencies.size(), lastSampleRate);
-    filterChain.get<3>().state->getMagnitudeForFrequencyArray(frequencies.data(),
-        highShelfMagnitudes.data(),
-        frequencies.size(), lastSampleRate);
-     
-    filterChain.setBypassed<0>(bypassedBands[0]);
-    filterChain.setBypassed<1>(bypassedBands[1]);
-    filterChain.setBypassed<2>(bypassedBands[2]);
-    filterChain.setBypassed<3>(bypassedBands[3]);
-
-    for (int i = 0; i < 4; ++i)
-    {
-        tree.addParameterListener(getFilterCutoffParamName(i), this);
-        tree.addParameterListener(getFilterQParamName(i), this);
-        tree.addParameterListener(getFilterGainParamName(i), this);
-        tree.addParameterListener(getFilterActiveName(i), this);
-    }
-    
-    updatePlots(); 
-}
-
-void ParametricEQAudioProcessor::updatePlots()
-{
-    //Update total response 
-    juce::FloatVectorOperations::fill(magnitudes.data(), 1, magnitudes.size());
-    for (int i = 0; i < 4; ++i)
-    {
-        if (!bypassedBands[i])
-        {
-            juce::FloatVectorOperations::multiply(magnitudes.data(), getMagnitudes(i).data(), magnitudes.size());
-        }
-    }
-    sendChangeMessage();
-}
-
-const std::vector<double>& ParametricEQAudioProcessor::getMagnitudes(int index)
-{
-    switch (index)
-    {
-    case 0: return lowShelfMagnitudes; break;
-    case 1: return lowMidsMagnitudes; break;
-    case 2: return highMidsMagnitudes; break;
-    case 3: return highShelfMagnitudes; break; 
-    case 4: return magnitudes; break;
-    }
-}
-
-void ParametricEQAudioProcessor::createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble)
-{
-    p.startNewSubPath(float(bounds.getX()), mags[0] > 0 ? float(bounds.getCentreY() - pixelsPerDouble * std::log(mags[0]) / std::log(2.0)) : bounds.getBottom());
-    const auto xFactor = static_cast<double> (bounds.getWidth()) / frequencies.size(); //spacing between points 
-    for (size_t i = 1; i < frequencies.size(); ++i)
-    {
-        p.lineTo(float(bounds.getX() + i * xFactor),
-            float(mags[i] > 0 ? bounds.getCentreY() - pixelsPerDouble * std::log(mags[i]) / std::log(2.0) : bounds.getBottom()));
-    }
-}
-
-void ParametricEQAudioProcessor::updateFilter(int index)
-{
-    juce::String cutoffID = getFilterCutoffParamName(index);
-    juce::String qID = getFilterQParamName(index);
-    juce::String gainID = getFilterGainParamName(index);
-    
-    float cutoff = *tree.getRawParameterValue(cutoffID);
-    float q = *tree.getRawParameterValue(qID);
-    float gainDB = *tree.getRawParameterValue(gainID);
-    float gain = juce::Decibels::decibelsToGain(gainDB);
-    
-
-    switch (index)
-    {
-    case 0: 
-        *filterChain.get<0>().state = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(lastSampleRate, cutoff, q, gain);
-        filterChain.get<0>().state->getMagnitudeForFrequencyArray(frequencies.data(), lowShelfMagnitudes.data(),
-            frequencies.size(), lastSampleRate);
-        break;
-    case 1: 
-        *filterChain.get<1>().state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(lastSampleRate, cutoff, q, gain); 
-        filterChain.get<1>().state->getMagnitudeForFrequencyArray(frequencies.data(), lowMidsMagnitudes.data(),
-            frequencies.size(), lastSampleRate);
-        break;
-    case 2: 
-        *filterChain.get<2>().state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(lastSampleRate, cutoff, q, gain); 
-        filterChain.get<2>().state->getMagnitudeForFrequencyArray(frequencies.data(), highMidsMagnitudes.data(),
-            frequencies.size(), lastSampleRate);
-        break;
-    case 3: 
-        *filterChain.get<3>().state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(lastSampleRate, cutoff, q, gain); 
-        filterChain.get<3>().state->getMagnitudeForFrequencyArray(frequencies.data(), highShelfMagnitudes.data(),
-            frequencies.size(), lastSampleRate);
-        break;
-    }
-    updatePlots();
-}
-
-ParametricEQAudioProcessor::~ParametricEQAudioProcessor()
-{
-
-}
-
-juce::AudioProcessorValueTreeState::ParameterLayout ParametricEQAudioProcessor::createParameterLayout()
-{
-    juce::NormalisableRange<float> fullParamCutoffRange(20.0f, 20000.0f);
-    fullParamCutoffRange.setSkewForCentre(883.9f);
-
-    juce::NormalisableRange<float> fullParamQRange(0.1f, 32.0f);
-    fullParamQRange.setSkewForCentre(5.7f);
-
-    juce::NormalisableRange<float> lowShelfCutoffRange(20.0f, 600.0f);
-    lowShelfCutoffRange.setSkewForCentre(134.2f);
-
-    juce::NormalisableRange<float> lowShelfQRange(0.1f, 2.0f);
-    lowShelfQRange.setSkewForCentre(1.0f);
-
-    juce::NormalisableRange<float> highShelfCutoffRange(3000.0f, 20000.0f);
-    highShelfCutoffRange.setSkewForCentre(6000.0f);
-
-    juce::NormalisableRange<float> highShelfQRange(0.1f, 2.0f);
-    highShelfQRange.setSkewForCentre(1.0f);
-
-    juce::NormalisableRange<float> gainRange(-24.0f, 24.0f);
-
-    std::vector <std::unique_ptr<juce::RangedAudioParameter>> params;
-    for (int i = 0; i < 4; ++i)
-    {
-        switch (i)
-        {
-        case 0: 
-        {
-            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), lowShelfCutoffRange, 134.2f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) {return juce::String(param, 1) + " Hz" ; });
-            params.push_back(std::move(cutoffParam));
-            auto qParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterQParamName(i), getFilterQParamName(i), lowShelfQRange, 0.62f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) {return juce::String(param, 2); });   
-            params.push_back(std::move(qParam));
-            break;
-        }
-        case 1: 
-        {
-            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), fullParamCutoffRange, 883.9f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) { return param > 1000 ? juce::String(param/1000.0f, 3) + " kHz" : juce::String(param,1) + " Hz"; });
-            params.push_back(std::move(cutoffParam));
-            auto qParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterQParamName(i), getFilterQParamName(i), fullParamQRange, 5.7f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) {return juce::String(param, 2); });
-            params.push_back(std::move(qParam));
-            break;
-        }
-        case 2:
-        {
-            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), fullParamCutoffRange, 883.9f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) { return param > 1000 ? juce::String(param/1000.0f, 3) + " kHz" : juce::String(param, 1) + " Hz";});
-            params.push_back(std::move(cutoffParam));
-            auto qParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterQParamName(i), getFilterQParamName(i), fullParamQRange, 5.7f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) {return juce::String(param, 2); });
-            params.push_back(std::move(qParam));
-            break;
-            
-        }
-        case 3:
-        {
-            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), highShelfCutoffRange, 6000.0f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) {return juce::String(param/1000.0f, 3) + " kHz"; });
-            params.push_back(std::move(cutoffParam));
-            auto qParam = std::make_unique<juce::AudioParameterFloat>
-                (getFilterQParamName(i), getFilterQParamName(i), highShelfQRange, 0.62f,
-                    juce::String(), juce::AudioProcessorParameter::genericParameter,
-                    [](float param, int) {return juce::String(param, 2); });
-            params.push_back(std::move(qParam));
-            break;
-        }
-        }
-        auto gainParam = std::make_unique<juce::AudioParameterFloat>
-            (getFilterGainParamName(i), getFilterGainParamName(i), gainRange, 0.0f,
-                juce::String(), juce::AudioProcessorParameter::genericParameter,
-                [](float param, int) {return juce::String(param, 1) + " dB"; });
-        params.push_back(std::move(gainParam));
-        auto activeParam = std::make_unique<juce::AudioParameterBool>
-            (getFilterActiveName(i), getFilterActiveName(i), false, juce::String(), nullptr, nullptr);
-        params.push_back(std::move(activeParam));
-    }
-    return { params.begin(), params.end() };
-}
-
-void ParametricEQAudioProcessor::parameterChanged(const juce::String& parameter, float newValue)
-{
-    int index = getBandIndexFromID(parameter);
-    updateFilter(index);
-}
-
-void ParametricEQAudioProcessor::updateActiveBands(int index)
-{
-    //If index was bypassed and button clicked, set index active and vice versa
-    bool newBypassedState = bypassedBands[index] ? false : true;
-    bypassedBands[index] = newBypassedState;
-
-    filterChain.setBypassed<0>(bypassedBands[0]);
-    filterChain.setBypassed<1>(bypassedBands[1]);
-    filterChain.setBypassed<2>(bypassedBands[2]);
-    filterChain.setBypassed<3>(bypassedBands[3]);
-
-    sendChangeMessage();
-}
-
-bool ParametricEQAudioProcessor::isBypassed(int index) 
-{
-    return bypassedBands[index];
-}
-
-//==============================================================================
-const juce::String ParametricEQAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool ParametricEQAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool ParametricEQAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool ParametricEQAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double ParametricEQAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int ParametricEQAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int ParametricEQAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void ParametricEQAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String ParametricEQAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void ParametricEQAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void ParametricEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    lastSampleRate = sampleRate;
-
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
-
-    filterChain.prepare(spec);
-    filterChain.reset();
-}
-
-void ParametricEQAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool ParametricEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void ParametricEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-
-    juce::dsp::AudioBlock<float> block(buffer);
-    filterChain.process(juce::dsp::ProcessContextReplacing<float>(block));
-}
-
-//==============================================================================
-bool ParametricEQAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* ParametricEQAudioProcessor::createEditor()
-{
-    return new ParametricEQAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void ParametricEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    auto state = tree.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
-}
-
-void ParametricEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
-
-    if (xmlState.get() != nullptr) 
-    {
-        if (xmlState->hasTagName(tree.state.getType()))
-        {
-            tree.replaceState(juce::ValueTree::fromXml(*xmlState));
-        }
-    }
-    
-    for (int i = 0; i < 4; ++i)
-    {
-        juce::String activeID = getFilterActiveName(i);
-        bool active = *tree.getRawParameterValue(activeID);
-        if (active == bypassedBands[i])
-            updateActiveBands(i);
-        updateFilter(i);
-    }
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new ParametricEQAudioProcessor();
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+// MIDI CCs 102-117 (undefined in the MIDI spec) automate the parameters sample-accurately:
+// four consecutive controllers per band for cutoff, Q, gain and active.
+static const int firstAutomationController = 102;
+
+//Preferences for the machine rather than the session, in the user's application data
+struct ParametricEQAudioProcessor::MachineSettings
+{
+    MachineSettings()
+    {
+        juce::PropertiesFile::Options options;
+        options.applicationName = JucePlugin_Name;
+        options.filenameSuffix = ".settings";
+        options.osxLibrarySubFolder = "Application Support";
+        properties.setStorageParameters(options);
+
+        multithreadedProcessing = properties.getUserSettings()->getBoolValue("multithreadedProcessing", true);
+    }
+
+    juce::ApplicationProperties properties;
+    std::atomic<bool> multithreadedProcessing { true };
+};
+
+struct ParametricEQAudioProcessor::MessageThreadHandback : private juce::Timer
+{
+    MessageThreadHandback() { startTimerHz(30); }
+    ~MessageThreadHandback() override { stopTimer(); }
+
+    //Attached from prepareToPlay on any thread, detached by the destructor on the message thread
+    void attach(ParametricEQAudioProcessor* processor)
+    {
+        const juce::ScopedLock sl(lock);
+        processors.addIfNotAlreadyThere(processor);
+    }
+
+    void detach(ParametricEQAudioProcessor* processor)
+    {
+        const juce::ScopedLock sl(lock);
+        processors.removeFirstMatchingValue(processor);
+    }
+
+    //The lock isn't held while an instance sets its parameters, so a host that takes its own
+    //lock around prepareToPlay can't deadlock against the host notifications
+    void timerCallback() override
+    {
+        for (int i = 0;; ++i)
+        {
+            ParametricEQAudioProcessor* processor = nullptr;
+            {
+                const juce::ScopedLock sl(lock);
+                if (i >= processors.size())
+                    return;
+                processor = processors.getUnchecked(i);
+            }
+            processor->handBackPendingWork();
+        }
+    }
+
+    juce::CriticalSection lock;
+    juce::Array<ParametricEQAudioProcessor*> processors;
+};
+
+juce::String ParametricEQAudioProcessor::getFilterCutoffParamName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Cutoff"; break;
+    case 1: return "Band1Cutoff"; break; 
+    case 2: return "Band2Cutoff"; break;
+    case 3: return "Band3Cutoff"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterQParamName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Q"; break;
+    case 1: return "Band1Q"; break;
+    case 2: return "Band2Q"; break;
+    case 3: return "Band3Q"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterGainParamName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Gain"; break;
+    case 1: return "Band1Gain"; break;
+    case 2: return "Band2Gain"; break;
+    case 3: return "Band3Gain"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterBandNum(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0"; break;
+    case 1: return "Band1"; break;
+    case 2: return "Band2"; break;
+    case 3: return "Band3"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterBandName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Low Shelf"; break;
+    case 1: return "Param 1"; break;
+    case 2: return "Param 2"; break;
+    case 3: return "High Shelf"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterMagnitudeName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Magnitude"; break;
+    case 1: return "Band1Magnitude"; break;
+    case 2: return "Band2Magnitude"; break;
+    case 3: return "Band3Magnitude"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterActiveName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Active"; break;
+    case 1: return "Band1Active"; break;
+    case 2: return "Band2Active"; break;
+    case 3: return "Band3Active"; break;
+    }
+    return "invalid";
+}
+juce::String ParametricEQAudioProcessor::getFilterSoloName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Solo"; break;
+    case 1: return "Band1Solo"; break;
+    case 2: return "Band2Solo"; break;
+    case 3: return "Band3Solo"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterTypeName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Type"; break;
+    case 3: return "Band3Type"; break;
+    }
+    return "invalid";
+}
+
+juce::String ParametricEQAudioProcessor::getFilterSlopeName(int index)
+{
+    switch (index)
+    {
+    case 0: return "Band0Slope"; break;
+    case 3: return "Band3Slope"; break;
+    }
+    return "invalid";
+}
+
+bool ParametricEQAudioProcessor::hasFilterType(int index)
+{
+    return index == 0 || index == 3;
+}
+
+int ParametricEQAudioProcessor::getSlopeDBPerOctave(int slope)
+{
+    switch (slope)
+    {
+    case 0: return 12; break;
+    case 1: return 24; break;
+    case 2: return 36; break;
+    case 3: return 48; break;
+    case 4: return 72; break;
+    case 5: return 96; break;
+    }
+    return 12;
+}
+
+int ParametricEQAudioProcessor::getBandIndexFromID(juce::String paramID)
+{
+    for (int i = 0; i < 4; ++i)
+        if (paramID.startsWith(getFilterBandNum(i)))
+        {
+            return int(i);
+        }
+    return -1;
+}
+
+//==============================================================================
+ParametricEQAudioProcessor::ParametricEQAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       ), tree(*this, nullptr, "PARAMS", createParameterLayout()), lastSampleRate(44100.0f)
+
+#endif
+{
+    //Hosts construct every instance of a session, and scan the plugin, before anything plays.
+    //Only the audio path is set up here: the program bank is designed when it is first needed
+    //and the plots when something subscribes to them.
+    for (int i = 0; i < 16; ++i)
+    {
+        automationParameters[i] = tree.getParameter(getAutomationParamName(i));
+        rawAutomationParameters[i] = tree.getRawParameterValue(getAutomationParamName(i));
+        pendingParameterValues[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (hasFilterType(i))
+        {
+            rawTypeParameters[i] = tree.getRawParameterValue(getFilterTypeName(i));
+            rawSlopeParameters[i] = tree.getRawParameterValue(getFilterSlopeName(i));
+        }
+        designFilter(i);
+    }
+
+    initialisePrograms();
+
+    for (int i = 0; i < 4; ++i)
+    {
+        tree.addParameterListener(getFilterCutoffParamName(i), this);
+        tree.addParameterListener(getFilterQParamName(i), this);
+        tree.addParameterListener(getFilterGainParamName(i), this);
+        tree.addParameterListener(getFilterActiveName(i), this);
+        if (hasFilterType(i))
+        {
+            tree.addParameterListener(getFilterTypeName(i), this);
+            tree.addParameterListener(getFilterSlopeName(i), this);
+        }
+    }
+}
+
+void ParametricEQAudioProcessor::addPlotListener(juce::ChangeListener* listener)
+{
+    addChangeListener(listener);
+    if (plotSubscribers++ > 0)
+        return;
+
+    startTimerHz(30);
+
+    //Nothing was kept up to date while unsubscribed, so the first subscriber gets one fresh batch
+    if (frequencies.empty())
+    {
+        frequencies.resize(300);
+        for (int i = 0; i < frequencies.size(); ++i) {
+            frequencies[i] = 20.0 * std::pow(2.0, i / 30.0);
+        }
+        magnitudes.resize(frequencies.size());
+        sectionMagnitudes.resize(frequencies.size());
+        lowShelfMagnitudes.resize(frequencies.size());
+        lowMidsMagnitudes.resize(frequencies.size());
+        highMidsMagnitudes.resize(frequencies.size());
+        highShelfMagnitudes.resize(frequencies.size());
+    }
+
+    dirtyPlotBands = 0;
+    for (int i = 0; i < 4; ++i)
+        updateMagnitudes(i);
+    updatePlots();
+}
+
+void ParametricEQAudioProcessor::removePlotListener(juce::ChangeListener* listener)
+{
+    removeChangeListener(listener);
+    if (--plotSubscribers == 0)
+        stopTimer();
+}
+
+void ParametricEQAudioProcessor::updatePlots()
+{
+    if (plotSubscribers == 0)
+        return;
+
+    //Update total response 
+    juce::FloatVectorOperations::fill(magnitudes.data(), 1, magnitudes.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!bypassedBands[i].load())
+        {
+            juce::FloatVectorOperations::multiply(magnitudes.data(), getMagnitudes(i).data(), magnitudes.size());
+        }
+    }
+    sendChangeMessage();
+}
+
+const std::vector<double>& ParametricEQAudioProcessor::getMagnitudes(int index)
+{
+    switch (index)
+    {
+    case 0: return lowShelfMagnitudes; break;
+    case 1: return lowMidsMagnitudes; break;
+    case 2: return highMidsMagnitudes; break;
+    case 3: return highShelfMagnitudes; break; 
+    case 4: return magnitudes; break;
+    }
+}
+
+void ParametricEQAudioProcessor::createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble)
+{
+    if (mags.empty())
+        return;
+
+    p.startNewSubPath(float(bounds.getX()), mags[0] > 0 ? float(bounds.getCentreY() - pixelsPerDouble * std::log(mags[0]) / std::log(2.0)) : bounds.getBottom());
+    const auto xFactor = static_cast<double> (bounds.getWidth()) / frequencies.size(); //spacing between points 
+    for (size_t i = 1; i < frequencies.size(); ++i)
+    {
+        p.lineTo(float(bounds.getX() + i * xFactor),
+            float(mags[i] > 0 ? bounds.getCentreY() - pixelsPerDouble * std::log(mags[i]) / std::log(2.0) : bounds.getBottom()));
+    }
+}
+
+juce::dsp::IIR::Coefficients<float>::Ptr ParametricEQAudioProcessor::makeBandCoefficients(int index, float cutoff, float q, float gainDB, double sampleRate)
+{
+    float gain = juce::Decibels::decibelsToGain(gainDB);
+
+    switch (index)
+    {
+    case 0: return juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, cutoff, q, gain); break;
+    case 3: return juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, cutoff, q, gain); break;
+    }
+    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, cutoff, q, gain);
+}
+
+static void normaliseSection(const double* c, float* section)
+{
+    //c is b0, b1, b2, a0, a1, a2, as ArrayCoefficients returns them
+    section[0] = float(c[0] / c[3]);
+    section[1] = float(c[1] / c[3]);
+    section[2] = float(c[2] / c[3]);
+    section[3] = float(c[4] / c[3]);
+    section[4] = float(c[5] / c[3]);
+}
+
+int ParametricEQAudioProcessor::makeBandSections(int index, int type, int slope, float cutoff, float q, float gainDB, double sampleRate, float (*sections)[5])
+{
+    if (!hasFilterType(index) || type == shelfType)
+    {
+        float gain = juce::Decibels::decibelsToGain(gainDB);
+
+        std::array<float, 6> c;
+        switch (index)
+        {
+        case 0: c = juce::dsp::IIR::ArrayCoefficients<float>::makeLowShelf(sampleRate, cutoff, q, gain); break;
+        case 3: c = juce::dsp::IIR::ArrayCoefficients<float>::makeHighShelf(sampleRate, cutoff, q, gain); break;
+        default: c = juce::dsp::IIR::ArrayCoefficients<float>::makePeakFilter(sampleRate, cutoff, q, gain); break;
+        }
+
+        const float a0 = c[3];
+        sections[0][0] = c[0] / a0;
+        sections[0][1] = c[1] / a0;
+        sections[0][2] = c[2] / a0;
+        sections[0][3] = c[4] / a0;
+        sections[0][4] = c[5] / a0;
+        return 1;
+    }
+
+    //Cuts are designed in double: the high Q sections of a steep low cut lose accuracy in float.
+    //A Linkwitz-Riley cut is a Butterworth of half the order applied twice. Q and gain are unused.
+    const bool highPass = index == 0;
+    const bool linkwitzRiley = type == linkwitzRileyCut;
+    const int order = getSlopeDBPerOctave(slope) / (linkwitzRiley ? 12 : 6);
+    int numSections = 0;
+
+    //Only Linkwitz-Riley reaches odd orders; its real pole applied twice is one second order section
+    if (order % 2 == 1)
+    {
+        auto c = highPass ? juce::dsp::IIR::ArrayCoefficients<double>::makeFirstOrderHighPass(sampleRate, cutoff)
+                          : juce::dsp::IIR::ArrayCoefficients<double>::makeFirstOrderLowPass(sampleRate, cutoff);
+        const double squared[6] = { c[0] * c[0], 2.0 * c[0] * c[1], c[1] * c[1], c[2] * c[2], 2.0 * c[2] * c[3], c[3] * c[3] };
+        normaliseSection(squared, sections[numSections++]);
+    }
+
+    //One section per conjugate pole pair, Q from the pair's angle to the negative real axis
+    for (int k = 0; k < order / 2; ++k)
+    {
+        const double angle = juce::MathConstants<double>::pi * (2 * k + 1 + order % 2) / (2.0 * order);
+        const double sectionQ = 1.0 / (2.0 * std::cos(angle));
+        auto c = highPass ? juce::dsp::IIR::ArrayCoefficients<double>::makeHighPass(sampleRate, cutoff, sectionQ)
+                          : juce::dsp::IIR::ArrayCoefficients<double>::makeLowPass(sampleRate, cutoff, sectionQ);
+
+        normaliseSection(c.data(), sections[numSections++]);
+        if (linkwitzRiley)
+            normaliseSection(c.data(), sections[numSections++]);
+    }
+    return numSections;
+}
+
+int ParametricEQAudioProcessor::getBandShape(int index, int type, int slope)
+{
+    return hasFilterType(index) && type != shelfType ? type * 8 + slope : 0;
+}
+
+juce::dsp::IIR::Coefficients<float>& ParametricEQAudioProcessor::getChainCoefficients(FilterChain& chain, int index)
+{
+    switch (index)
+    {
+    case 0: return *chain.get<0>().state; break;
+    case 1: return *chain.get<1>().state; break;
+    case 2: return *chain.get<2>().state; break;
+    }
+    return *chain.get<3>().state;
+}
+
+void ParametricEQAudioProcessor::setChainBypassed(FilterChain& chain, const bool* bypassed)
+{
+    chain.setBypassed<0>(bypassed[0]);
+    chain.setBypassed<1>(bypassed[1]);
+    chain.setBypassed<2>(bypassed[2]);
+    chain.setBypassed<3>(bypassed[3]);
+}
+
+void ParametricEQAudioProcessor::designFilter(int index)
+{
+    designBands(1 << index);
+}
+
+void ParametricEQAudioProcessor::designBands(int bands)
+{
+    //Any thread, and never waits. Reading the parameters and publishing the design under one
+    //lock keeps two threads moving the same band from publishing their designs out of order.
+    //A thread that finds the lock taken leaves its bands flagged: the holder reads the
+    //parameters after the flag was set, so it designs them with the new values. A holder makes
+    //a few passes at most, so a storm of edits can't keep the audio thread here; whatever is
+    //still flagged after that is left to the timer.
+    bandsToDesign.fetch_or(bands);
+    for (int pass = 0; pass < 4 && bandsToDesign.load() != 0; ++pass)
+    {
+        const juce::SpinLock::ScopedTryLockType sl(designLock);
+        if (!sl.isLocked())
+            return;
+
+        //Controller values not yet pushed into the parameters count, or this would undo them
+        const int flagged = bandsToDesign.exchange(0);
+        for (int i = 0; i < 4; ++i)
+        {
+            if ((flagged & (1 << i)) == 0)
+                continue;
+            float cutoff = getAutomatedValue(i * 4);
+            float q = getAutomatedValue(i * 4 + 1);
+            float gainDB = getAutomatedValue(i * 4 + 2);
+            setCascadeBand(i, getFilterType(i), getFilterSlope(i), cutoff, q, gainDB);
+
+            const bool bypassed = getAutomatedValue(i * 4 + 3) < 0.5f;
+            bypassedBands[i] = bypassed;
+            for (auto& cascade : cascades)
+                cascade.setBandBypassed(i, bypassed);
+        }
+    }
+}
+
+void ParametricEQAudioProcessor::setCascadeBand(int band, int type, int slope, float cutoff, float q, float gainDB)
+{
+    //makeBandSections doesn't allocate, so this is safe on the audio thread too
+    float sections[BiquadCascade::maxSectionsPerBand][5];
+    int numSections = makeBandSections(band, type, slope, cutoff, q, gainDB, lastSampleRate, sections);
+
+    for (auto& cascade : cascades)
+        cascade.setBandSections(band, sections, numSections, getBandShape(band, type, slope));
+}
+
+int ParametricEQAudioProcessor::getFilterType(int index) const
+{
+    return rawTypeParameters[index] != nullptr ? juce::roundToInt(rawTypeParameters[index]->load()) : int(shelfType);
+}
+
+int ParametricEQAudioProcessor::getFilterSlope(int index) const
+{
+    return rawSlopeParameters[index] != nullptr ? juce::roundToInt(rawSlopeParameters[index]->load()) : 0;
+}
+
+void ParametricEQAudioProcessor::updateMagnitudes(int index)
+{
+    //Message thread only, like everything the plots read
+    float cutoff = *tree.getRawParameterValue(getFilterCutoffParamName(index));
+    float q = *tree.getRawParameterValue(getFilterQParamName(index));
+    float gainDB = *tree.getRawParameterValue(getFilterGainParamName(index));
+    float sections[BiquadCascade::maxSectionsPerBand][5];
+    int numSections = makeBandSections(index, getFilterType(index), getFilterSlope(index), cutoff, q, gainDB, lastSampleRate, sections);
+
+    double* mags = nullptr;
+    switch (index)
+    {
+    case 0: mags = lowShelfMagnitudes.data(); break;
+    case 1: mags = lowMidsMagnitudes.data(); break;
+    case 2: mags = highMidsMagnitudes.data(); break;
+    case 3: mags = highShelfMagnitudes.data(); break;
+    }
+
+    //The band's response is the product of its sections'
+    std::fill(mags, mags + frequencies.size(), 1.0);
+    for (int s = 0; s < numSections; ++s)
+    {
+        juce::dsp::IIR::Coefficients<float> coefficients(sections[s][0], sections[s][1], sections[s][2], 1.0f, sections[s][3], sections[s][4]);
+        coefficients.getMagnitudeForFrequencyArray(frequencies.data(), sectionMagnitudes.data(), frequencies.size(), lastSampleRate);
+        for (size_t n = 0; n < frequencies.size(); ++n)
+            mags[n] *= sectionMagnitudes[n];
+    }
+}
+
+void ParametricEQAudioProcessor::updateFilter(int index)
+{
+    PARAMETRICEQ_TRACE_SCOPE("updateFilter");
+    ++designGeneration;
+    designFilter(index);
+    markPlotsDirty(1 << index);
+}
+
+void ParametricEQAudioProcessor::updateAllFilters()
+{
+    PARAMETRICEQ_TRACE_SCOPE("updateAllFilters");
+    //Batch version of updateFilter: one design per band, one total response, one change message
+    ++designGeneration;
+    designBands(0xf);
+    markPlotsDirty(0xf);
+}
+
+void ParametricEQAudioProcessor::markPlotsDirty(int bands)
+{
+    //Parameter changes arrive on any thread, so this only flags the bands. The plots are rebuilt
+    //by the timer on the message thread, and only while someone is subscribed to them.
+    if (plotSubscribers == 0)
+        return;
+
+    dirtyPlotBands.fetch_or(bands);
+}
+
+void ParametricEQAudioProcessor::updateDirtyPlots()
+{
+    int dirty = dirtyPlotBands.exchange(0);
+    if (dirty == 0 || plotSubscribers == 0)
+        return;
+
+    for (int i = 0; i < 4; ++i)
+        if (dirty & (1 << i))
+            updateMagnitudes(i);
+    updatePlots();
+}
+
+ParametricEQAudioProcessor::~ParametricEQAudioProcessor()
+{
+    stopTimer();
+    if (messageThreadHandback != nullptr)
+        (*messageThreadHandback)->detach(this);
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout ParametricEQAudioProcessor::createParameterLayout()
+{
+    juce::NormalisableRange<float> fullParamCutoffRange(20.0f, 20000.0f);
+    fullParamCutoffRange.setSkewForCentre(883.9f);
+
+    juce::NormalisableRange<float> fullParamQRange(0.1f, 32.0f);
+    fullParamQRange.setSkewForCentre(5.7f);
+
+    juce::NormalisableRange<float> lowShelfCutoffRange(20.0f, 600.0f);
+    lowShelfCutoffRange.setSkewForCentre(134.2f);
+
+    juce::NormalisableRange<float> lowShelfQRange(0.1f, 2.0f);
+    lowShelfQRange.setSkewForCentre(1.0f);
+
+    juce::NormalisableRange<float> highShelfCutoffRange(3000.0f, 20000.0f);
+    highShelfCutoffRange.setSkewForCentre(6000.0f);
+
+    juce::NormalisableRange<float> highShelfQRange(0.1f, 2.0f);
+    highShelfQRange.setSkewForCentre(1.0f);
+
+    juce::NormalisableRange<float> gainRange(-24.0f, 24.0f);
+
+    std::vector <std::unique_ptr<juce::RangedAudioParameter>> params;
+    for (int i = 0; i < 4; ++i)
+    {
+        switch (i)
+        {
+        case 0: 
+        {
+            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), lowShelfCutoffRange, 134.2f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) {return juce::String(param, 1) + " Hz" ; });
+            params.push_back(std::move(cutoffParam));
+            auto qParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterQParamName(i), getFilterQParamName(i), lowShelfQRange, 0.62f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) {return juce::String(param, 2); });   
+            params.push_back(std::move(qParam));
+            break;
+        }
+        case 1: 
+        {
+            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), fullParamCutoffRange, 883.9f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) { return param > 1000 ? juce::String(param/1000.0f, 3) + " kHz" : juce::String(param,1) + " Hz"; });
+            params.push_back(std::move(cutoffParam));
+            auto qParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterQParamName(i), getFilterQParamName(i), fullParamQRange, 5.7f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) {return juce::String(param, 2); });
+            params.push_back(std::move(qParam));
+            break;
+        }
+        case 2:
+        {
+            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), fullParamCutoffRange, 883.9f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) { return param > 1000 ? juce::String(param/1000.0f, 3) + " kHz" : juce::String(param, 1) + " Hz";});
+            params.push_back(std::move(cutoffParam));
+            auto qParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterQParamName(i), getFilterQParamName(i), fullParamQRange, 5.7f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) {return juce::String(param, 2); });
+            params.push_back(std::move(qParam));
+            break;
+            
+        }
+        case 3:
+        {
+            auto cutoffParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterCutoffParamName(i), getFilterCutoffParamName(i), highShelfCutoffRange, 6000.0f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) {return juce::String(param/1000.0f, 3) + " kHz"; });
+            params.push_back(std::move(cutoffParam));
+            auto qParam = std::make_unique<juce::AudioParameterFloat>
+                (getFilterQParamName(i), getFilterQParamName(i), highShelfQRange, 0.62f,
+                    juce::String(), juce::AudioProcessorParameter::genericParameter,
+                    [](float param, int) {return juce::String(param, 2); });
+            params.push_back(std::move(qParam));
+            break;
+        }
+        }
+        auto gainParam = std::make_unique<juce::AudioParameterFloat>
+            (getFilterGainParamName(i), getFilterGainParamName(i), gainRange, 0.0f,
+                juce::String(), juce::AudioProcessorParameter::genericParameter,
+                [](float param, int) {return juce::String(param, 1) + " dB"; });
+        params.push_back(std::move(gainParam));
+        auto activeParam = std::make_unique<juce::AudioParameterBool>
+            (getFilterActiveName(i), getFilterActiveName(i), false, juce::String(), nullptr, nullptr);
+        params.push_back(std::move(activeParam));
+    }
+
+    //Appended after the original parameters so hosts that address parameters by index keep their automation
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!hasFilterType(i))
+            continue;
+
+        auto typeParam = std::make_unique<juce::AudioParameterChoice>
+            (getFilterTypeName(i), getFilterTypeName(i), juce::StringArray { "Shelf", "Butterworth Cut", "Linkwitz-Riley Cut" }, int(shelfType));
+        params.push_back(std::move(typeParam));
+        auto slopeParam = std::make_unique<juce::AudioParameterChoice>
+            (getFilterSlopeName(i), getFilterSlopeName(i), juce::StringArray { "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct", "72 dB/oct", "96 dB/oct" }, 1);
+        params.push_back(std::move(slopeParam));
+    }
+    return { params.begin(), params.end() };
+}
+
+void ParametricEQAudioProcessor::parameterChanged(const juce::String& parameter, float newValue)
+{
+    PARAMETRICEQ_TRACE_SCOPE("parameterChanged");
+    if (batchThread.load() == juce::Thread::getCurrentThreadId())
+        return;
+
+    int index = getBandIndexFromID(parameter);
+    updateFilter(index);
+}
+
+void ParametricEQAudioProcessor::updateActiveBands(int index)
+{
+    //Active is a parameter like the others: the band's bypass is designed with its sections,
+    //from the parameter, so the button, the host and the controllers can't undo each other
+    updateFilter(index);
+}
+
+bool ParametricEQAudioProcessor::isBypassed(int index) 
+{
+    return bypassedBands[index];
+}
+
+//==============================================================================
+const juce::String ParametricEQAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool ParametricEQAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool ParametricEQAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool ParametricEQAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double ParametricEQAudioProcessor::getTailLengthSeconds() const
+{
+    return 0.0;
+}
+
+int ParametricEQAudioProcessor::getNumPrograms()
+{
+    return numPrograms;
+}
+
+int ParametricEQAudioProcessor::getCurrentProgram()
+{
+    return currentProgram;
+}
+
+void ParametricEQAudioProcessor::setCurrentProgram (int index)
+{
+    if (!juce::isPositiveAndBelow(index, numPrograms))
+        return;
+
+    //A host may pick a program before preparing anything to play
+    if (!programsDesigned)
+        designAllPrograms();
+
+    selectProgram(index);
+    applyProgramParameters(pendingProgramParameters.exchange(-1));
+}
+
+const juce::String ParametricEQAudioProcessor::getProgramName (int index)
+{
+    return juce::isPositiveAndBelow(index, numPrograms) ? programs[index].name : juce::String();
+}
+
+void ParametricEQAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    if (juce::isPositiveAndBelow(index, numPrograms))
+        programs[index].name = newName;
+}
+
+void ParametricEQAudioProcessor::storeProgram(int index)
+{
+    if (!juce::isPositiveAndBelow(index, numPrograms))
+        return;
+
+    auto& program = programs[index];
+    for (int i = 0; i < 4; ++i)
+    {
+        program.cutoff[i] = *tree.getRawParameterValue(getFilterCutoffParamName(i));
+        program.q[i] = *tree.getRawParameterValue(getFilterQParamName(i));
+        program.gainDB[i] = *tree.getRawParameterValue(getFilterGainParamName(i));
+        program.active[i] = *tree.getRawParameterValue(getFilterActiveName(i)) >= 0.5f;
+        program.type[i] = getFilterType(i);
+        program.slope[i] = getFilterSlope(i);
+    }
+    ++designGeneration;
+    designProgram(program);
+    currentProgram = index;
+}
+
+void ParametricEQAudioProcessor::initialisePrograms()
+{
+    //Factory bank. Per band: cutoff, Q, gain (dB), active
+    struct BandPreset { float cutoff, q, gainDB; bool active; };
+    struct ProgramPreset { const char* name; BandPreset bands[4]; };
+
+    static const ProgramPreset factoryPrograms[numPrograms] =
+    {
+        { "Flat",           { { 134.2f, 0.62f,   0.0f, false }, { 883.9f, 5.7f,  0.0f, false }, { 883.9f, 5.7f, 0.0f, false }, { 6000.0f,  0.62f,   0.0f, false } } },
+        { "Warm",           { { 120.0f, 0.7f,    3.0f, true  }, { 400.0f, 1.0f, -2.0f, true  }, { 883.9f, 5.7f, 0.0f, false }, { 8000.0f,  0.7f,   -2.0f, true  } } },
+        { "Bright",         { { 134.2f, 0.62f,   0.0f, false }, { 883.9f, 5.7f,  0.0f, false }, { 3000.0f, 1.2f, 2.0f, true  }, { 8000.0f,  0.7f,    4.0f, true  } } },
+        { "Vocal Presence", { { 100.0f, 0.7f,   -4.0f, true  }, { 300.0f, 1.5f, -2.0f, true  }, { 3500.0f, 1.2f, 3.0f, true  }, { 10000.0f, 0.7f,    2.0f, true  } } },
+        { "Kick Punch",     { { 60.0f,  0.7f,    4.0f, true  }, { 350.0f, 2.0f, -4.0f, true  }, { 4000.0f, 1.5f, 3.0f, true  }, { 6000.0f,  0.62f,   0.0f, false } } },
+        { "De-Mud",         { { 134.2f, 0.62f,   0.0f, false }, { 250.0f, 1.4f, -4.0f, true  }, { 883.9f, 5.7f, 0.0f, false }, { 6000.0f,  0.62f,   0.0f, false } } },
+        { "Air",            { { 134.2f, 0.62f,   0.0f, false }, { 883.9f, 5.7f,  0.0f, false }, { 883.9f, 5.7f, 0.0f, false }, { 12000.0f, 0.7f,    5.0f, true  } } },
+        { "Telephone",      { { 300.0f, 0.7f,  -24.0f, true  }, { 1200.0f, 1.0f, 6.0f, true  }, { 883.9f, 5.7f, 0.0f, false }, { 3000.0f,  0.7f,  -24.0f, true  } } }
+    };
+
+    for (int p = 0; p < numPrograms; ++p)
+    {
+        programs[p].name = factoryPrograms[p].name;
+        for (int i = 0; i < 4; ++i)
+        {
+            programs[p].cutoff[i] = factoryPrograms[p].bands[i].cutoff;
+            programs[p].q[i] = factoryPrograms[p].bands[i].q;
+            programs[p].gainDB[i] = factoryPrograms[p].bands[i].gainDB;
+            programs[p].active[i] = factoryPrograms[p].bands[i].active;
+            programs[p].type[i] = shelfType;
+            programs[p].slope[i] = 1;
+        }
+    }
+}
+
+void ParametricEQAudioProcessor::designProgram(PresetSnapshot& program)
+{
+    const juce::ScopedLock sl(programDesignLock);
+    const int slot = getWritableDesign(program);
+    auto& design = program.designs[slot];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        design.numSections[i] = makeBandSections(i, program.type[i], program.slope[i], program.cutoff[i], program.q[i],
+                                                 program.gainDB[i], lastSampleRate, design.coefficients[i]);
+        design.shapes[i] = getBandShape(i, program.type[i], program.slope[i]);
+        design.bypassed[i] = !program.active[i];
+    }
+    publishDesign(program, slot);
+}
+
+int ParametricEQAudioProcessor::getWritableDesign(const PresetSnapshot& program) const
+{
+    //A slot is free unless it is published, handed to the audio thread or being loaded by it.
+    //pendingDesign is read first: the audio thread marks a design as loading before taking it.
+    for (;;)
+    {
+        const FilterDesign* pending = pendingDesign.load();
+        const FilterDesign* loading = loadingDesign.load();
+        for (int slot = 0; slot < numDesignSlots; ++slot)
+        {
+            const FilterDesign* design = &program.designs[slot];
+            if (slot != program.currentDesign && design != pending && design != loading)
+                return slot;
+        }
+
+        //All three taken only while the audio thread is copying a design out, which is brief
+        juce::Thread::yield();
+    }
+}
+
+void ParametricEQAudioProcessor::publishDesign(PresetSnapshot& program, int slot)
+{
+    const int previous = program.currentDesign.exchange(slot);
+
+    //A change to this program the audio thread hasn't picked up yet gets the new design instead,
+    //which also releases the old slot
+    FilterDesign* expected = &program.designs[previous];
+    pendingDesign.compare_exchange_strong(expected, &program.designs[slot]);
+}
+
+void ParametricEQAudioProcessor::designAllPrograms()
+{
+    for (auto& program : programs)
+        designProgram(program);
+    programsDesigned = true;
+}
+
+void ParametricEQAudioProcessor::selectProgram(int index)
+{
+    //Safe to call from the audio thread: no allocation and no filter design
+    auto& program = programs[index];
+    pendingDesign = &program.designs[program.currentDesign];
+    currentProgram = index;
+    pendingProgramParameters = index;
+}
+
+void ParametricEQAudioProcessor::applyProgramParameters(int index)
+{
+    PARAMETRICEQ_TRACE_SCOPE("applyProgramParameters");
+    if (!juce::isPositiveAndBelow(index, numPrograms))
+        return;
+
+    //The audio thread already has the designed snapshot, so only mirror it into the
+    //parameters and plots here without touching the filter chains
+    auto& program = programs[index];
+    {
+        ScopedParameterBatch batch(*this);
+        for (int i = 0; i < 4; ++i)
+        {
+            setParameterValue(getFilterCutoffParamName(i), program.cutoff[i]);
+            setParameterValue(getFilterQParamName(i), program.q[i]);
+            setParameterValue(getFilterGainParamName(i), program.gainDB[i]);
+            setParameterValue(getFilterActiveName(i), program.active[i] ? 1.0f : 0.0f);
+            if (hasFilterType(i))
+            {
+                setParameterValue(getFilterTypeName(i), float(program.type[i]));
+                setParameterValue(getFilterSlopeName(i), float(program.slope[i]));
+            }
+        }
+    }
+
+    for (int i = 0; i < 4; ++i)
+        bypassedBands[i] = !program.active[i];
+    ++designGeneration;
+    markPlotsDirty(0xf);
+}
+
+void ParametricEQAudioProcessor::handBackPendingWork()
+{
+    //Everything here is a few atomic loads when nothing is waiting
+    if (pendingProgramParameters.load() >= 0)
+        applyProgramParameters(pendingProgramParameters.exchange(-1));
+    applyPendingControllerValues();
+    if (bandsToDesign.load() != 0)
+        designBands(0);
+}
+
+void ParametricEQAudioProcessor::timerCallback()
+{
+    //Handed back here as well, so a watched instance's plots show the new values straight away
+    handBackPendingWork();
+    updateDirtyPlots();
+}
+
+void ParametricEQAudioProcessor::loadDesign(BiquadCascade& cascade, const FilterDesign& design)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        cascade.setBandSections(i, design.coefficients[i], design.numSections[i], design.shapes[i]);
+        cascade.setBandBypassed(i, design.bypassed[i]);
+    }
+}
+
+void ParametricEQAudioProcessor::processCrossfade(float* const* channels, int startChannel, int endChannel, int numSamples)
+{
+    //Runs the outgoing and incoming cascades side by side and ramps linearly between them.
+    //Only touches its own channels, so disjoint ranges can be faded on different threads.
+    auto& outgoing = cascades[activeCascade];
+    auto& incoming = cascades[1 - activeCascade];
+    const int chunkSize = fadeBuffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int chunkLength = juce::jmin(chunkSize, numSamples - start);
+        for (int ch = startChannel; ch < endChannel; ++ch)
+        {
+            chunkChannels[size_t(ch)] = channels[ch] + start;
+            juce::FloatVectorOperations::copy(fadeChannels[size_t(ch)], chunkChannels[size_t(ch)], chunkLength);
+        }
+
+        outgoing.processChannels(chunkChannels.data(), startChannel, endChannel, chunkLength);
+        incoming.processChannels(fadeChannels.data(), startChannel, endChannel, chunkLength);
+
+        for (int ch = startChannel; ch < endChannel; ++ch)
+        {
+            auto* out = chunkChannels[size_t(ch)];
+            auto* in = fadeChannels[size_t(ch)];
+            int remaining = juce::jmax(0, fadeSamplesRemaining - start);
+            for (int n = 0; n < chunkLength; ++n)
+            {
+                float g = remaining > 0 ? 1.0f - float(remaining) / float(fadeLengthSamples) : 1.0f;
+                out[n] += g * (in[n] - out[n]);
+                if (remaining > 0)
+                    --remaining;
+            }
+        }
+    }
+}
+
+void ParametricEQAudioProcessor::processChannels(float* const* channels, int startChannel, int endChannel, int numSamples, bool crossfade)
+{
+    if (crossfade)
+        processCrossfade(channels, startChannel, endChannel, numSamples);
+    else
+        cascades[activeCascade].processChannels(channels, startChannel, endChannel, numSamples);
+}
+
+void ParametricEQAudioProcessor::processChannelGroup(void* context, int startChannel, int endChannel)
+{
+    //Worker threads don't inherit the audio thread's denormal mode
+    juce::ScopedNoDenormals noDenormals;
+    auto* job = static_cast<ChannelJob*>(context);
+    job->processor->processChannels(job->channels, startChannel, endChannel, job->numSamples, job->crossfade);
+}
+
+ParametricEQAudioProcessor::MachineSettings& ParametricEQAudioProcessor::getMachineSettings()
+{
+    //Message thread
+    if (machineSettings == nullptr)
+        machineSettings = std::make_unique<juce::SharedResourcePointer<MachineSettings>>();
+    return **machineSettings;
+}
+
+void ParametricEQAudioProcessor::setMultithreadedProcessing(bool shouldBeEnabled)
+{
+    auto& settings = getMachineSettings();
+    settings.multithreadedProcessing = shouldBeEnabled;
+    settings.properties.getUserSettings()->setValue("multithreadedProcessing", shouldBeEnabled);
+}
+
+bool ParametricEQAudioProcessor::isMultithreadedProcessing()
+{
+    return getMachineSettings().multithreadedProcessing;
+}
+
+//==============================================================================
+void ParametricEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    PARAMETRICEQ_TRACE_SCOPE("prepareToPlay");
+    //Staged before the cascades are prepared, so they start out with the new designs
+    redesignForSampleRate(sampleRate);
+
+    //Everything the audio thread needs per call is sized here, once per configuration
+    const int numChannels = getTotalNumOutputChannels();
+    for (auto& cascade : cascades)
+    {
+        cascade.prepare(numChannels);
+        cascade.reset();
+    }
+    segmentChannels.assign(size_t(numChannels), nullptr);
+    chunkChannels.assign(size_t(numChannels), nullptr);
+
+    //10 ms program crossfade
+    fadeLengthSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.01));
+    fadeSamplesRemaining = 0;
+    fadeBuffer.setSize(numChannels, samplesPerBlock);
+    fadeChannels.assign(size_t(numChannels), nullptr);
+    for (int ch = 0; ch < numChannels; ++ch)
+        fadeChannels[size_t(ch)] = fadeBuffer.getWritePointer(ch);
+    matchEQ.prepare(sampleRate);
+
+    //From here on the audio thread may leave controller values and programs for the message thread
+    if (messageThreadHandback == nullptr)
+    {
+        messageThreadHandback = std::make_unique<juce::SharedResourcePointer<MessageThreadHandback>>();
+        (*messageThreadHandback)->attach(this);
+    }
+
+    //The process-wide pool, for layouts large enough to make waking its workers worthwhile
+    getMachineSettings();
+    if (numChannels < parallelChannelThreshold || juce::SystemStats::getNumCpus() < 2)
+        workerPool.reset();
+    else if (workerPool == nullptr)
+        workerPool = std::make_unique<juce::SharedResourcePointer<ChannelWorkerPool>>();
+}
+
+void ParametricEQAudioProcessor::redesignForSampleRate(double sampleRate)
+{
+    PARAMETRICEQ_TRACE_SCOPE("redesignForSampleRate");
+    lastSampleRate = float(sampleRate);
+
+    //Reuse the designs from the last time this rate was prepared if nothing was edited since
+    DesignCacheEntry* entry = nullptr;
+    for (auto& cached : designCache)
+        if (cached.sampleRate == sampleRate && cached.generation == designGeneration)
+            entry = &cached;
+
+    const bool cacheHit = entry != nullptr;
+    if (cacheHit)
+    {
+        //Published the same way as a fresh design, so a program change in flight keeps its slot
+        const juce::ScopedLock sl(programDesignLock);
+        for (int p = 0; p < numPrograms; ++p)
+        {
+            const int slot = getWritableDesign(programs[p]);
+            programs[p].designs[slot] = entry->programDesigns[p];
+            publishDesign(programs[p], slot);
+        }
+        programsDesigned = true;
+    }
+    else
+    {
+        //The oldest entry makes room; the cache is only allocated by the first prepare
+        if (designCache.size() < designCacheSize)
+            designCache.emplace_back();
+        entry = &designCache[size_t(nextCacheEntry)];
+        nextCacheEntry = (nextCacheEntry + 1) % designCacheSize;
+
+        entry->sampleRate = sampleRate;
+        entry->generation = designGeneration;
+
+        designAllPrograms();
+        for (int p = 0; p < numPrograms; ++p)
+            entry->programDesigns[p] = programs[p].designs[programs[p].currentDesign];
+    }
+
+    //All bands in one batch, under the same lock as designBands so a concurrent edit can't be
+    //overwritten. Holders never wait, so this waits only for a design in progress.
+    {
+        const juce::SpinLock::ScopedLockType sl(designLock);
+        bandsToDesign = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            //An edit that arrived since the lookup wins over the cached design
+            if (!cacheHit || entry->generation != designGeneration)
+            {
+                float cutoff = getAutomatedValue(i * 4);
+                float q = getAutomatedValue(i * 4 + 1);
+                float gainDB = getAutomatedValue(i * 4 + 2);
+                entry->numBandSections[i] = makeBandSections(i, getFilterType(i), getFilterSlope(i), cutoff, q, gainDB, sampleRate, entry->bandSections[i]);
+                entry->bandShapes[i] = getBandShape(i, getFilterType(i), getFilterSlope(i));
+            }
+
+            for (auto& cascade : cascades)
+                cascade.setBandSections(i, entry->bandSections[i], entry->numBandSections[i], entry->bandShapes[i]);
+        }
+    }
+
+    //Bands flagged by threads that found the lock taken above
+    designBands(0);
+
+    //The plots depend on the rate too
+    markPlotsDirty(0xf);
+}
+
+void ParametricEQAudioProcessor::releaseResources()
+{
+    workerPool.reset();
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool ParametricEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // Anything from mono up to 128 channels; every channel is filtered the same way.
+    auto numOutputChannels = layouts.getMainOutputChannelSet().size();
+    if (numOutputChannels < 1 || numOutputChannels > 128)
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void ParametricEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    PARAMETRICEQ_TRACE_SCOPE("processBlock");
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    const int numSamples = buffer.getNumSamples();
+
+    //Controllers and program loads below write to either cascade before it is updated, and must
+    //never take the lock the other threads block on
+    for (auto& cascade : cascades)
+        cascade.registerAudioThread();
+
+    //The unprocessed input is what a match is computed against
+    matchEQ.pushSamples(buffer);
+
+    //Without events the whole buffer is one segment, exactly as before
+    if (midiMessages.isEmpty())
+    {
+        processSegment(buffer, 0, numSamples);
+        return;
+    }
+
+    //Otherwise split at every program change or automation controller so it lands on its own
+    //sample. The timer hands the new values to the parameters afterwards.
+    int segmentStart = 0;
+    for (const auto metadata : midiMessages)
+    {
+        auto message = metadata.getMessage();
+        bool isProgramChange = message.isProgramChange() && juce::isPositiveAndBelow(message.getProgramChangeNumber(), numPrograms);
+        int paramIndex = message.isController() ? message.getControllerNumber() - firstAutomationController : -1;
+
+        if (!isProgramChange && !juce::isPositiveAndBelow(paramIndex, 16))
+            continue;
+
+        int position = juce::jlimit(0, numSamples, metadata.samplePosition);
+        if (position > segmentStart)
+        {
+            processSegment(buffer, segmentStart, position - segmentStart);
+            segmentStart = position;
+        }
+
+        if (isProgramChange)
+            selectProgram(message.getProgramChangeNumber());
+        else
+            applyControllerChange(paramIndex, message.getControllerValue() / 127.0f);
+    }
+
+    if (segmentStart < numSamples)
+        processSegment(buffer, segmentStart, numSamples - segmentStart);
+}
+
+void ParametricEQAudioProcessor::processSegment(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (auto* design = pendingDesign.load())
+    {
+        //Marked as loading before it is taken, so no writer reuses the slot until it is copied
+        loadingDesign = design;
+        if (pendingDesign.compare_exchange_strong(design, nullptr))
+        {
+            //A new program arriving mid-fade jumps straight to the incoming cascade first
+            if (fadeSamplesRemaining > 0)
+            {
+                activeCascade = 1 - activeCascade;
+                fadeSamplesRemaining = 0;
+            }
+            loadDesign(cascades[1 - activeCascade], *design);
+            cascades[1 - activeCascade].reset();
+            fadeSamplesRemaining = fadeLengthSamples;
+        }
+        loadingDesign = nullptr;
+    }
+
+    //The host's channel pointers go straight to the cascade; only split segments need offsets
+    const int numChannels = juce::jmin(buffer.getNumChannels(), int(segmentChannels.size()));
+    float* const* channels = buffer.getArrayOfWritePointers();
+    if (startSample > 0)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            segmentChannels[size_t(ch)] = channels[ch] + startSample;
+        channels = segmentChannels.data();
+    }
+
+    //Offline renders are judged by throughput, not latency, so they take the time blocked kernel
+    const bool offline = isNonRealtime();
+    for (auto& cascade : cascades)
+        cascade.setTimeBlockedProcessing(offline);
+
+    //During a fade only the incoming cascade takes edits; the outgoing one plays the old
+    //program unchanged to the end of the fade
+    bool crossfade = fadeSamplesRemaining > 0;
+    cascades[crossfade ? 1 - activeCascade : activeCascade].update();
+    if (crossfade)
+    {
+        //Without a scratch buffer there is nothing to fade through, so jump to the new program
+        if (fadeBuffer.getNumSamples() == 0)
+        {
+            activeCascade = 1 - activeCascade;
+            fadeSamplesRemaining = 0;
+            crossfade = false;
+        }
+    }
+
+    //The settings are attached in prepareToPlay, before any pool is
+    if (workerPool != nullptr && numChannels >= parallelChannelThreshold
+        && (*machineSettings)->multithreadedProcessing.load(std::memory_order_relaxed))
+    {
+        ChannelJob job { this, channels, numSamples, crossfade };
+        (*workerPool)->run(processChannelGroup, &job, numChannels, channelsPerGroup);
+    }
+    else
+    {
+        processChannels(channels, 0, numChannels, numSamples, crossfade);
+    }
+
+    if (crossfade)
+    {
+        fadeSamplesRemaining = juce::jmax(0, fadeSamplesRemaining - numSamples);
+        if (fadeSamplesRemaining == 0)
+            activeCascade = 1 - activeCascade;
+    }
+}
+
+juce::String ParametricEQAudioProcessor::getAutomationParamName(int paramIndex)
+{
+    //Four consecutive slots per band: cutoff, Q, gain, active
+    int band = paramIndex / 4;
+    switch (paramIndex % 4)
+    {
+    case 0: return getFilterCutoffParamName(band); break;
+    case 1: return getFilterQParamName(band); break;
+    case 2: return getFilterGainParamName(band); break;
+    case 3: return getFilterActiveName(band); break;
+    }
+    return "invalid";
+}
+
+float ParametricEQAudioProcessor::getAutomatedValue(int paramIndex)
+{
+    //A controller value the message thread hasn't pushed into the parameter yet wins over the parameter
+    float pending = pendingParameterValues[paramIndex];
+    return std::isnan(pending) ? rawAutomationParameters[paramIndex]->load() : pending;
+}
+
+void ParametricEQAudioProcessor::applyControllerChange(int paramIndex, float normalisedValue)
+{
+    //Through the same design path as every other change to the band, so a controller and the
+    //host moving one band can't publish out of order. Usually designed right here at the
+    //event's sample; if another thread is designing, it picks the band up instead.
+    pendingParameterValues[paramIndex] = automationParameters[paramIndex]->convertFrom0to1(normalisedValue);
+    ++designGeneration;
+    designFilter(paramIndex / 4);
+}
+
+void ParametricEQAudioProcessor::applyPendingControllerValues()
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        float value = pendingParameterValues[i].load();
+        if (std::isnan(value))
+            continue;
+
+        setParameterValue(getAutomationParamName(i), value);
+
+        //Cleared only once the parameter holds the value, so a design made in between still
+        //sees it, and only if the audio thread hasn't queued a newer one meanwhile
+        pendingParameterValues[i].compare_exchange_strong(value, std::numeric_limits<float>::quiet_NaN());
+    }
+}
+
+//==============================================================================
+MatchEQ& ParametricEQAudioProcessor::getMatchEQ()
+{
+    return matchEQ;
+}
+
+bool ParametricEQAudioProcessor::startMatch()
+{
+    //The fit searches the same ranges the parameters allow
+    MatchEQ::BandRange ranges[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        switch (i)
+        {
+        case 0: ranges[i].shape = MatchEQ::Shape::lowShelf; break;
+        case 3: ranges[i].shape = MatchEQ::Shape::highShelf; break;
+        default: ranges[i].shape = MatchEQ::Shape::peak; break;
+        }
+        ranges[i].cutoff = tree.getParameterRange(getFilterCutoffParamName(i));
+        ranges[i].q = tree.getParameterRange(getFilterQParamName(i));
+        ranges[i].gainDB = tree.getParameterRange(getFilterGainParamName(i));
+    }
+
+    matchEQ.onFitFinished = [this](const MatchEQ::Result& result) { applyMatch(result); };
+    return matchEQ.startFit(ranges, lastSampleRate);
+}
+
+void ParametricEQAudioProcessor::applyMatch(const MatchEQ::Result& result)
+{
+    //Same batching as a session recall: set everything, then redesign once
+    {
+        ScopedParameterBatch batch(*this);
+        for (int i = 0; i < 4; ++i)
+        {
+            setParameterValue(getFilterCutoffParamName(i), result.cutoff[i]);
+            setParameterValue(getFilterQParamName(i), result.q[i]);
+            setParameterValue(getFilterGainParamName(i), result.gainDB[i]);
+            setParameterValue(getFilterActiveName(i), 1.0f);
+            if (hasFilterType(i))
+                setParameterValue(getFilterTypeName(i), float(shelfType));
+        }
+    }
+
+    updateAllFilters();
+}
+
+//==============================================================================
+bool ParametricEQAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* ParametricEQAudioProcessor::createEditor()
+{
+    PARAMETRICEQ_TRACE_SCOPE("createEditor");
+    return new ParametricEQAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+// Compact session state: magic, version, band count, then cutoff/Q/gain/active per band and the
+// end bands' type and slope, then the current program and the program bank in the same form.
+// Sessions saved before this format existed are still read through the XML path.
+static const int stateMagic = 0x53514550; // "PEQS"
+static const int stateVersion = 1;
+
+void ParametricEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    PARAMETRICEQ_TRACE_SCOPE("getStateInformation");
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateMagic);
+    stream.writeInt(stateVersion);
+    stream.writeCompressedInt(4);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        stream.writeFloat(*tree.getRawParameterValue(getFilterCutoffParamName(i)));
+        stream.writeFloat(*tree.getRawParameterValue(getFilterQParamName(i)));
+        stream.writeFloat(*tree.getRawParameterValue(getFilterGainParamName(i)));
+        stream.writeFloat(*tree.getRawParameterValue(getFilterActiveName(i)));
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!hasFilterType(i))
+            continue;
+        stream.writeCompressedInt(getFilterType(i));
+        stream.writeCompressedInt(getFilterSlope(i));
+    }
+
+    stream.writeCompressedInt(currentProgram);
+    stream.writeCompressedInt(numPrograms);
+    for (auto& program : programs)
+    {
+        stream.writeString(program.name);
+        for (int i = 0; i < 4; ++i)
+        {
+            stream.writeFloat(program.cutoff[i]);
+            stream.writeFloat(program.q[i]);
+            stream.writeFloat(program.gainDB[i]);
+            stream.writeFloat(program.active[i] ? 1.0f : 0.0f);
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            if (!hasFilterType(i))
+                continue;
+            stream.writeCompressedInt(program.type[i]);
+            stream.writeCompressedInt(program.slope[i]);
+        }
+    }
+}
+
+void ParametricEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    PARAMETRICEQ_TRACE_SCOPE("setStateInformation");
+    {
+        ScopedParameterBatch batch(*this);
+        if (!readBinaryState(data, sizeInBytes))
+            readXmlState(data, sizeInBytes);
+    }
+
+    updateAllFilters();
+}
+
+void ParametricEQAudioProcessor::setParameterValue(const juce::String& paramID, float value)
+{
+    //For changes the user asked for (programs, match); session recall goes through applySessionState
+    if (auto* param = tree.getParameter(paramID))
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+//Reads that fail on a truncated or corrupt state instead of quietly returning zeros
+static bool readStateFloat(juce::MemoryInputStream& stream, float& value)
+{
+    if (stream.getNumBytesRemaining() < juce::int64(sizeof(float)))
+        return false;
+    value = stream.readFloat();
+    return std::isfinite(value);
+}
+
+static bool readStateInt(juce::MemoryInputStream& stream, int& value)
+{
+    //A compressed int is a size byte followed by up to four bytes
+    if (stream.getNumBytesRemaining() < 1)
+        return false;
+    const int size = static_cast<const juce::uint8*>(stream.getData())[stream.getPosition()] & 0x7f;
+    if (size > 4 || stream.getNumBytesRemaining() < 1 + size)
+        return false;
+    value = stream.readCompressedInt();
+    return true;
+}
+
+static bool readStateString(juce::MemoryInputStream& stream, juce::String& value)
+{
+    //Strings are null terminated; one without a terminator runs off the end of the state
+    const auto* start = static_cast<const char*>(stream.getData()) + stream.getPosition();
+    if (std::memchr(start, 0, size_t(stream.getNumBytesRemaining())) == nullptr)
+        return false;
+    value = stream.readString();
+    return true;
+}
+
+bool ParametricEQAudioProcessor::parseBinaryState(const void* data, int sizeInBytes, SessionState& session)
+{
+    if (data == nullptr || sizeInBytes < 12)
+        return false;
+
+    juce::MemoryInputStream stream(data, static_cast<size_t> (sizeInBytes), false);
+    if (stream.readInt() != stateMagic)
+        return false;
+
+    if (stream.readInt() != stateVersion)
+        return false;
+
+    //Counts are checked against what is left in the stream before anything is read with them
+    const int bytesPerBand = 4 * int(sizeof(float));
+    int numBands = 0;
+    if (!readStateInt(stream, numBands) || numBands < 4 || numBands > 64
+        || stream.getNumBytesRemaining() < juce::int64(numBands) * bytesPerBand)
+        return false;
+
+    auto readBands = [&stream](ProgramSettings& settings)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            float active = 0.0f;
+            if (!readStateFloat(stream, settings.cutoff[i]) || !readStateFloat(stream, settings.q[i])
+                || !readStateFloat(stream, settings.gainDB[i]) || !readStateFloat(stream, active))
+                return false;
+            settings.active[i] = active >= 0.5f;
+            settings.type[i] = shelfType;
+            settings.slope[i] = 1;
+        }
+        return true;
+    };
+
+    auto readTypes = [&stream](ProgramSettings& settings)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            if (!hasFilterType(i))
+                continue;
+            if (!readStateInt(stream, settings.type[i]) || !readStateInt(stream, settings.slope[i]))
+                return false;
+            settings.type[i] = juce::jlimit(0, int(linkwitzRileyCut), settings.type[i]);
+            settings.slope[i] = juce::jlimit(0, 5, settings.slope[i]);
+        }
+        return true;
+    };
+
+    if (!readBands(session.bands))
+        return false;
+    stream.skipNextBytes((numBands - 4) * bytesPerBand);
+    if (!readTypes(session.bands))
+        return false;
+
+    if (!readStateInt(stream, session.currentProgram) || !readStateInt(stream, session.numStoredPrograms)
+        || session.numStoredPrograms < 0 || session.numStoredPrograms > 128)
+        return false;
+
+    for (int p = 0; p < session.numStoredPrograms; ++p)
+    {
+        ProgramSettings stored;
+        if (!readStateString(stream, stored.name) || !readBands(stored) || !readTypes(stored))
+            return false;
+        if (p < numPrograms)
+            session.programs[p] = stored;
+    }
+    return true;
+}
+
+void ParametricEQAudioProcessor::applySessionState(const SessionState& session)
+{
+    //Restored through the tree's state, the same path the XML format takes, rather than one
+    //parameter at a time as if each had been edited. Parameters that don't change send nothing.
+    auto state = tree.copyState();
+    auto setValue = [&state](const juce::String& paramID, float value)
+    {
+        auto param = state.getChildWithProperty("id", paramID);
+        if (param.isValid())
+            param.setProperty("value", value, nullptr);
+    };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        setValue(getFilterCutoffParamName(i), session.bands.cutoff[i]);
+        setValue(getFilterQParamName(i), session.bands.q[i]);
+        setValue(getFilterGainParamName(i), session.bands.gainDB[i]);
+        setValue(getFilterActiveName(i), session.bands.active[i] ? 1.0f : 0.0f);
+        if (hasFilterType(i))
+        {
+            setValue(getFilterTypeName(i), float(session.bands.type[i]));
+            setValue(getFilterSlopeName(i), float(session.bands.slope[i]));
+        }
+    }
+    tree.replaceState(state);
+
+    for (int p = 0; p < juce::jmin(session.numStoredPrograms, numPrograms); ++p)
+        static_cast<ProgramSettings&>(programs[p]) = session.programs[p];
+    designAllPrograms();
+
+    if (juce::isPositiveAndBelow(session.currentProgram, numPrograms))
+        currentProgram = session.currentProgram;
+}
+
+bool ParametricEQAudioProcessor::readBinaryState(const void* data, int sizeInBytes)
+{
+    SessionState session;
+    if (!parseBinaryState(data, sizeInBytes, session))
+        return false;
+
+    applySessionState(session);
+    return true;
+}
+
+bool ParametricEQAudioProcessor::readXmlState(const void* data, int sizeInBytes)
+{
+    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
+
+    if (xmlState.get() != nullptr && xmlState->hasTagName(tree.state.getType()))
+    {
+        //Sessions from before the cuts existed only had shelves. replaceState leaves a parameter
+        //the state doesn't mention where it was, so the defaults are written in explicitly.
+        auto state = juce::ValueTree::fromXml(*xmlState);
+        for (int i = 0; i < 4; ++i)
+        {
+            if (!hasFilterType(i))
+                continue;
+
+            const std::pair<juce::String, int> defaults[] = { { getFilterTypeName(i), int(shelfType) }, { getFilterSlopeName(i), 1 } };
+            for (auto& paramDefault : defaults)
+            {
+                if (state.getChildWithProperty("id", paramDefault.first).isValid())
+                    continue;
+
+                juce::ValueTree param("PARAM");
+                param.setProperty("id", paramDefault.first, nullptr);
+                param.setProperty("value", float(paramDefault.second), nullptr);
+                state.appendChild(param, nullptr);
+            }
+        }
+
+        tree.replaceState(state);
+        return true;
+    }
+    return false;
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    //Traced out here so the scope covers the member initialisers too, the tree's parameters above all
+    PARAMETRICEQ_TRACE_SCOPE("constructor");
+    return new ParametricEQAudioProcessor();
+}
@@ -1,102 +1,331 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-
-//==============================================================================
-/**
-*/
-class ParametricEQAudioProcessor : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener,
-    public juce::ChangeBroadcaster
-{
-public:
-    //==============================================================================
-    ParametricEQAudioProcessor();
-    ~ParametricEQAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
-#endif
-
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram(int index) override;
-    const juce::String getProgramName(int index) override;
-    void changeProgramName(int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation(juce::MemoryBlock& destData) override;
-    void setStateInformation(const void* data, int sizeInBytes) override;
-
-    //==============================================================================
-    void updateFilter(int index);
-
-    juce::String getFilterCutoffParamName(int index);  
-    juce::String getFilterQParamName(int index);
-    juce::String getFilterGainParamName(int index); 
-    juce::String getFilterBandName(int index);
-    juce::String getFilterBandNum(int index);
-    juce::String getFilterMagnitudeName(int index);
-    juce::String getFilterActiveName(int index);
-    juce::String getFilterSoloName(int index); 
-    bool isBypassed(int index);
-    int getBandIndexFromID(juce::String paramID);
-
-    juce::AudioProcessorValueTreeState tree;
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout(); 
-    void parameterChanged(const juce::String& parameter, float newValue) override;
-
-    void updateActiveBands(int index); 
-
-    void updatePlots();
-    const std::vector<double>& getMagnitudes(int index);
-    void createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble);
-
-    std::vector<double> lowShelfMagnitudes;
-    std::vector<double> lowMidsMagnitudes;
-    std::vector<double> highMidsMagnitudes;
-    std::vector<double> highShelfMagnitudes;
-
-private:
-    using FilterProcessor = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients <float>>;
-    FilterProcessor lowShelf;
-    FilterProcessor lowMids;
-    FilterProcessor highMids;
-    FilterProcessor highShelf;
-    juce::dsp::ProcessorChain<FilterProcessor, FilterProcessor, FilterProcessor, FilterProcessor> filterChain;
-
-    std::vector<double> frequencies;
-    std::vector<double> magnitudes;
-
-    float lastSampleRate;
-    bool bypassedBands[4] = { true, true, true, true };
-
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParametricEQAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TraceRecorder.h"
+#include "BiquadCascade.h"
+#include "ChannelWorkerPool.h"
+#include "MatchEQ.h"
+
+//==============================================================================
+/**
+*/
+class ParametricEQAudioProcessor : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener,
+    public juce::ChangeBroadcaster, private juce::Timer
+{
+public:
+    //==============================================================================
+    ParametricEQAudioProcessor();
+    ~ParametricEQAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+#endif
+
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram(int index) override;
+    const juce::String getProgramName(int index) override;
+    void changeProgramName(int index, const juce::String& newName) override;
+    void storeProgram(int index);
+
+    //==============================================================================
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    //==============================================================================
+    void updateFilter(int index);
+    void updateAllFilters();
+
+    juce::String getFilterCutoffParamName(int index);  
+    juce::String getFilterQParamName(int index);
+    juce::String getFilterGainParamName(int index); 
+    juce::String getFilterBandName(int index);
+    juce::String getFilterBandNum(int index);
+    juce::String getFilterMagnitudeName(int index);
+    juce::String getFilterActiveName(int index);
+    juce::String getFilterSoloName(int index); 
+    juce::String getFilterTypeName(int index);
+    juce::String getFilterSlopeName(int index);
+    bool isBypassed(int index);
+    int getBandIndexFromID(juce::String paramID);
+
+    juce::AudioProcessorValueTreeState tree;
+    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout(); 
+    void parameterChanged(const juce::String& parameter, float newValue) override;
+
+    void updateActiveBands(int index); 
+
+    //Response plots are computed only while at least one listener is subscribed (message thread)
+    void addPlotListener(juce::ChangeListener* listener);
+    void removePlotListener(juce::ChangeListener* listener);
+
+    void updatePlots();
+    const std::vector<double>& getMagnitudes(int index);
+    void createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble);
+
+    std::vector<double> lowShelfMagnitudes;
+    std::vector<double> lowMidsMagnitudes;
+    std::vector<double> highMidsMagnitudes;
+    std::vector<double> highShelfMagnitudes;
+
+    //==============================================================================
+    //The ProcessorChain form of the bands, kept as the reference the engines are validated against
+    //by the Validator console app
+    using FilterProcessor = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients <float>>;
+    using FilterChain = juce::dsp::ProcessorChain<FilterProcessor, FilterProcessor, FilterProcessor, FilterProcessor>;
+
+    static juce::dsp::IIR::Coefficients<float>::Ptr makeBandCoefficients(int index, float cutoff, float q, float gainDB, double sampleRate);
+
+    //The end bands are either shelves or steep cuts: a low cut for band 0, a high cut for band 3
+    enum FilterType { shelfType, butterworthCut, linkwitzRileyCut };
+
+    static bool hasFilterType(int index);
+    static int getSlopeDBPerOctave(int slope);
+
+    //Designs a band as normalised second order sections (b0, b1, b2, a1, a2) for BiquadCascade.
+    //Allocation free. Returns the number of sections, at most BiquadCascade::maxSectionsPerBand.
+    static int makeBandSections(int index, int type, int slope, float cutoff, float q, float gainDB, double sampleRate, float (*sections)[5]);
+
+    //The shape BiquadCascade is told a band has: the same for every shelf or peak, one per cut type and slope
+    static int getBandShape(int index, int type, int slope);
+    static juce::dsp::IIR::Coefficients<float>& getChainCoefficients(FilterChain& chain, int index);
+    static void setChainBypassed(FilterChain& chain, const bool* bypassed);
+
+    //Match EQ: learns the input's spectrum, fits the bands to a reference and applies the result
+    MatchEQ& getMatchEQ();
+    bool startMatch();
+    void applyMatch(const MatchEQ::Result& result);
+
+    //Splits channel groups across worker threads for large channel counts. A preference for the
+    //machine, shared by every instance and kept in the user's settings rather than the session.
+    void setMultithreadedProcessing(bool shouldBeEnabled);
+    bool isMultithreadedProcessing();
+
+private:
+    juce::SharedResourcePointer<TraceRecorder> traceRecorder;
+
+    //Two cascades so a program change can crossfade from the old settings into the new ones.
+    //Parameter edits are written to both; the audio thread decides which one is audible, and
+    //holds back the outgoing one's edits until its fade is over.
+    BiquadCascade cascades[2];
+    int activeCascade = 0;
+    std::vector<float*> segmentChannels;
+    std::vector<float*> chunkChannels;
+    std::vector<float*> fadeChannels;
+
+    std::vector<double> frequencies;
+    std::vector<double> magnitudes;
+    std::vector<double> sectionMagnitudes;
+
+    //Type and slope only exist for the end bands; the others read as shelfType
+    std::atomic<float>* rawTypeParameters[4] = {};
+    std::atomic<float>* rawSlopeParameters[4] = {};
+
+    int getFilterType(int index) const;
+    int getFilterSlope(int index) const;
+
+    //Read by whichever thread designs a band, so both are atomic
+    std::atomic<float> lastSampleRate;
+    std::atomic<bool> bypassedBands[4] = { { true }, { true }, { true }, { true } };
+
+    //Parameter callbacks can come from the host's automation thread, the message thread and
+    //the audio thread at once. Each flags its band and designs whatever is flagged if it gets
+    //designLock; a thread that doesn't leaves its band to the one holding it, so nobody waits.
+    //The plots are only rebuilt by the message thread's timer, for the bands flagged here.
+    juce::SpinLock designLock;
+    std::atomic<int> bandsToDesign { 0 };
+    std::atomic<int> dirtyPlotBands { 0 };
+    std::atomic<int> plotSubscribers { 0 };
+
+    //Mutes parameterChanged for the changes a batch (session recall, program, match) makes on
+    //its own thread, so the batch is designed once at the end. Changes from other threads still
+    //go through. Batches on different threads are serialised.
+    juce::CriticalSection batchLock;
+    std::atomic<juce::Thread::ThreadID> batchThread { nullptr };
+
+    struct ScopedParameterBatch
+    {
+        explicit ScopedParameterBatch(ParametricEQAudioProcessor& p) : processor(p), lock(p.batchLock) { processor.batchThread = juce::Thread::getCurrentThreadId(); }
+        ~ScopedParameterBatch() { processor.batchThread = nullptr; }
+        ParametricEQAudioProcessor& processor;
+        const juce::ScopedLock lock;
+    };
+
+    void designFilter(int index);
+    void designBands(int bands);
+    void setCascadeBand(int band, int type, int slope, float cutoff, float q, float gainDB);
+    void markPlotsDirty(int bands);
+    void updateDirtyPlots();
+    void updateMagnitudes(int index);
+    void setParameterValue(const juce::String& paramID, float value);
+    bool readBinaryState(const void* data, int sizeInBytes);
+    bool readXmlState(const void* data, int sizeInBytes);
+
+    //==============================================================================
+    //Program bank. Every snapshot carries its sections already designed for lastSampleRate,
+    //so switching programs on the audio thread is a pointer exchange and a copy of the sections.
+    struct FilterDesign
+    {
+        float coefficients[4][BiquadCascade::maxSectionsPerBand][5];
+        int numSections[4];
+        int shapes[4];
+        bool bypassed[4];
+    };
+
+    //Band settings as the parameters hold them
+    struct ProgramSettings
+    {
+        juce::String name;
+        float cutoff[4];
+        float q[4];
+        float gainDB[4];
+        bool active[4];
+        int type[4];
+        int slope[4];
+    };
+
+    //Three designs per program: the published one, one the audio thread may still be holding,
+    //and one to write the next design into. Writers are serialised by programDesignLock.
+    static constexpr int numDesignSlots = 3;
+
+    struct PresetSnapshot : ProgramSettings
+    {
+        FilterDesign designs[numDesignSlots];
+        std::atomic<int> currentDesign { 0 };
+    };
+
+    static constexpr int numPrograms = 8;
+    PresetSnapshot programs[numPrograms];
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingProgramParameters { -1 };
+    std::atomic<FilterDesign*> pendingDesign { nullptr };
+    std::atomic<FilterDesign*> loadingDesign { nullptr };
+    juce::CriticalSection programDesignLock;
+    std::atomic<bool> programsDesigned { false };
+
+    //A binary session, read and checked in full before any of it is applied
+    struct SessionState
+    {
+        ProgramSettings bands;
+        int currentProgram = -1;
+        int numStoredPrograms = 0;
+        ProgramSettings programs[numPrograms];
+    };
+
+    static bool parseBinaryState(const void* data, int sizeInBytes, SessionState& session);
+    void applySessionState(const SessionState& session);
+
+    //Designs for recently prepared sample rates, so a host switching back and forth (an offline
+    //bounce at 96k, then playback at 48k) gets the bands and programs back without redesigning.
+    //Any edit bumps the generation, which retires every entry.
+    struct DesignCacheEntry
+    {
+        double sampleRate = 0.0;
+        juce::uint32 generation = 0;
+        float bandSections[4][BiquadCascade::maxSectionsPerBand][5];
+        int numBandSections[4] = {};
+        int bandShapes[4] = {};
+        FilterDesign programDesigns[numPrograms];
+    };
+
+    static constexpr int designCacheSize = 4;
+    std::vector<DesignCacheEntry> designCache;
+    int nextCacheEntry = 0;
+    std::atomic<juce::uint32> designGeneration { 0 };
+
+    void redesignForSampleRate(double sampleRate);
+
+    juce::AudioBuffer<float> fadeBuffer;
+    int fadeLengthSamples = 441;
+    int fadeSamplesRemaining = 0;
+
+    void initialisePrograms();
+    void designProgram(PresetSnapshot& program);
+    int getWritableDesign(const PresetSnapshot& program) const;
+    void publishDesign(PresetSnapshot& program, int slot);
+    void designAllPrograms();
+    void selectProgram(int index);
+    void applyProgramParameters(int index);
+    void loadDesign(BiquadCascade& cascade, const FilterDesign& design);
+    void processCrossfade(float* const* channels, int startChannel, int endChannel, int numSamples);
+    void processSegment(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    //The timer only runs while the plots have a listener. Prepared instances are also attached
+    //to one timer for the whole process, which hands back what their audio thread leaves for
+    //the message thread, so an instance no editor is watching doesn't poll on its own.
+    struct MessageThreadHandback;
+    std::unique_ptr<juce::SharedResourcePointer<MessageThreadHandback>> messageThreadHandback;
+
+    void handBackPendingWork();
+    void timerCallback() override;
+
+    //==============================================================================
+    //Multithreaded processing. Below the threshold waking the workers costs more than it saves,
+    //so the pool is only created for layouts with at least that many channels.
+    static constexpr int parallelChannelThreshold = 16;
+    static constexpr int channelsPerGroup = 8;
+
+    struct ChannelJob
+    {
+        ParametricEQAudioProcessor* processor;
+        float* const* channels;
+        int numSamples;
+        bool crossfade;
+    };
+
+    //Both shared by the whole process and only attached once something needs them, so a
+    //constructor never starts threads or reads the settings file
+    struct MachineSettings;
+    std::unique_ptr<juce::SharedResourcePointer<MachineSettings>> machineSettings;
+    std::unique_ptr<juce::SharedResourcePointer<ChannelWorkerPool>> workerPool;
+
+    MachineSettings& getMachineSettings();
+
+    void processChannels(float* const* channels, int startChannel, int endChannel, int numSamples, bool crossfade);
+    static void processChannelGroup(void* context, int startChannel, int endChannel);
+
+    //==============================================================================
+    //Sample-accurate automation from MIDI CCs. Values are applied on the audio thread at the
+    //event's offset and handed to the message thread to update the parameters afterwards.
+    juce::RangedAudioParameter* automationParameters[16];
+    std::atomic<float>* rawAutomationParameters[16];
+    std::atomic<float> pendingParameterValues[16];
+
+    juce::String getAutomationParamName(int paramIndex);
+    float getAutomatedValue(int paramIndex);
+    void applyControllerChange(int paramIndex, float normalisedValue);
+    void applyPendingControllerValues();
+
+    //==============================================================================
+    MatchEQ matchEQ;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParametricEQAudioProcessor)
+};
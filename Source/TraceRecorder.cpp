@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.cpp
+    Created: 19 Oct 2026 11:40:05am
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+
+#if JUCE_WINDOWS
+ #include <process.h>
+#else
+ #include <pthread.h>
+ #include <unistd.h>
+ #if JUCE_LINUX || JUCE_ANDROID
+  #include <sys/syscall.h>
+ #endif
+#endif
+
+std::atomic<TraceRecorder*> TraceRecorder::instance { nullptr };
+
+namespace
+{
+    //Which ring buffer the calling thread writes to, valid for one recording generation
+    struct ThreadSlot
+    {
+        int generation = -1;
+        void* buffer = nullptr;
+    };
+
+    thread_local ThreadSlot threadSlot;
+
+    //The ids a system profiler shows for this thread and process
+    juce::uint64 getSystemThreadID() noexcept
+    {
+       #if JUCE_WINDOWS
+        return juce::uint64(juce::pointer_sized_uint(juce::Thread::getCurrentThreadId()));
+       #elif JUCE_LINUX || JUCE_ANDROID
+        return juce::uint64(syscall(SYS_gettid));
+       #elif JUCE_MAC || JUCE_IOS
+        uint64_t id = 0;
+        pthread_threadid_np(nullptr, &id);
+        return juce::uint64(id);
+       #else
+        return juce::uint64(juce::pointer_sized_uint(juce::Thread::getCurrentThreadId()));
+       #endif
+    }
+
+    int getSystemProcessID() noexcept
+    {
+       #if JUCE_WINDOWS
+        return _getpid();
+       #else
+        return int(getpid());
+       #endif
+    }
+}
+
+TraceRecorder::TraceRecorder()
+    : juce::Thread("EQ trace writer")
+{
+    instance = this;
+
+    auto path = juce::SystemStats::getEnvironmentVariable("PARAMETRICEQ_TRACE_FILE", {});
+    if (path.isNotEmpty())
+        start(juce::File::getCurrentWorkingDirectory().getChildFile(path));
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+    instance = nullptr;
+}
+
+void TraceRecorder::start(const juce::File& file)
+{
+    stop();
+
+    //A thread that saw recording == true before stop() may still be writing into its ring, so
+    //the indices are only reset once every such writer has left record()
+    waitForWriters();
+
+    //Buffers live until the recorder is destroyed, so a late writer can never touch freed memory
+    if (buffers == nullptr)
+        buffers.reset(new ThreadBuffer[maxThreads]);
+
+    for (int i = 0; i < maxThreads; ++i)
+    {
+        buffers[i].writeIndex = 0;
+        buffers[i].readIndex = 0;
+    }
+
+    {
+        const juce::ScopedLock sl(drainLock);
+        collected.clear();
+        collected.reserve(chunkSize);
+
+        file.deleteFile();
+        stream = std::make_unique<juce::FileOutputStream>(file);
+        if (stream->openedOk())
+            *stream << "{\"traceEvents\":[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getSystemProcessID()
+                    << ",\"args\":{\"name\":\"parametricEQ\"}}";
+        else
+            stream.reset();
+    }
+
+    droppedEvents = 0;
+    numBuffersClaimed = 0;
+    ++generation;
+    recording = true;
+
+    startThread();
+}
+
+void TraceRecorder::stop()
+{
+    if (!recording.exchange(false))
+        return;
+
+    stopThread(1000);
+    waitForWriters();
+    drain();
+    finishFile();
+}
+
+void TraceRecorder::waitForWriters() const noexcept
+{
+    while (activeWriters.load() != 0)
+        juce::Thread::yield();
+}
+
+bool TraceRecorder::isRecording() const noexcept
+{
+    return recording;
+}
+
+void TraceRecorder::beginEvent(const char* name) noexcept
+{
+    if (auto* recorder = instance.load(std::memory_order_acquire))
+        if (recorder->recording.load(std::memory_order_relaxed))
+            recorder->record(name, 'B');
+}
+
+void TraceRecorder::endEvent(const char* name) noexcept
+{
+    if (auto* recorder = instance.load(std::memory_order_acquire))
+        if (recorder->recording.load(std::memory_order_relaxed))
+            recorder->record(name, 'E');
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::getBufferForThisThread() noexcept
+{
+    int currentGeneration = generation.load(std::memory_order_acquire);
+    if (threadSlot.generation != currentGeneration)
+    {
+        int index = numBuffersClaimed.fetch_add(1);
+        threadSlot.buffer = index < maxThreads ? &buffers[index] : nullptr;
+        threadSlot.generation = currentGeneration;
+        if (index < maxThreads)
+            buffers[index].threadID = getSystemThreadID();
+    }
+    return static_cast<ThreadBuffer*> (threadSlot.buffer);
+}
+
+void TraceRecorder::record(const char* name, char phase) noexcept
+{
+    //Counted in before recording is checked again, so start() and stop() either see this writer
+    //or this writer sees that recording has stopped
+    ++activeWriters;
+
+    if (recording.load())
+    {
+        auto* buffer = getBufferForThisThread();
+        if (buffer == nullptr)
+        {
+            ++droppedEvents;
+        }
+        else
+        {
+            auto write = buffer->writeIndex.load(std::memory_order_relaxed);
+            auto read = buffer->readIndex.load(std::memory_order_acquire);
+            if (write - read >= bufferSize)
+            {
+                ++droppedEvents;
+            }
+            else
+            {
+                buffer->events[write & (bufferSize - 1)] = { name, juce::Time::getHighResolutionTicks(), phase };
+                buffer->writeIndex.store(write + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    --activeWriters;
+}
+
+void TraceRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        drain();
+        wait(50);
+    }
+}
+
+void TraceRecorder::drain()
+{
+    const juce::ScopedLock sl(drainLock);
+
+    int numThreads = juce::jmin(numBuffersClaimed.load(), maxThreads);
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto& buffer = buffers[i];
+        auto read = buffer.readIndex.load(std::memory_order_relaxed);
+        auto write = buffer.writeIndex.load(std::memory_order_acquire);
+
+        for (; read != write; ++read)
+        {
+            collected.push_back({ i, buffer.events[read & (bufferSize - 1)] });
+            if (collected.size() >= chunkSize)
+                writeChunk();
+        }
+
+        buffer.readIndex.store(read, std::memory_order_release);
+    }
+}
+
+void TraceRecorder::writeChunk()
+{
+    //Absolute timestamps on the same clock as the high resolution ticks, so traces from several
+    //runs or processes can be merged and compared
+    if (stream != nullptr)
+    {
+        const double microsecondsPerTick = 1.0e6 / double(juce::Time::getHighResolutionTicksPerSecond());
+        const int pid = getSystemProcessID();
+
+        for (auto& e : collected)
+        {
+            *stream << ",{\"name\":\"" << e.event.name << "\",\"cat\":\"eq\",\"ph\":\"" << juce::String::charToString(e.event.phase)
+                    << "\",\"pid\":" << pid << ",\"tid\":" << juce::String(buffers[e.thread].threadID.load())
+                    << ",\"ts\":" << juce::String(double(e.event.ticks) * microsecondsPerTick, 3) << "}";
+        }
+    }
+
+    collected.clear();
+}
+
+void TraceRecorder::finishFile()
+{
+    const juce::ScopedLock sl(drainLock);
+
+    writeChunk();
+    if (stream == nullptr)
+        return;
+
+    //Metadata events may come anywhere in the array, so the thread names go last, once every
+    //thread that recorded is known
+    const int pid = getSystemProcessID();
+    int numThreads = juce::jmin(numBuffersClaimed.load(), maxThreads);
+    for (int i = 0; i < numThreads; ++i)
+    {
+        const auto tid = juce::String(buffers[i].threadID.load());
+        *stream << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+                << ",\"args\":{\"name\":\"EQ thread " << tid << "\"}}";
+    }
+
+    *stream << "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << int(droppedEvents.load()) << "}}";
+    stream.reset();
+}
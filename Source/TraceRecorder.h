@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Created: 19 Oct 2026 11:40:05am
+    Author:  jrgehrig
+
+    Opt-in event tracing. Threads write begin/end events into their own
+    lock-free ring buffer; a background thread drains them and appends them
+    to a Chrome/Perfetto trace JSON file in chunks, which is closed off when
+    recording stops.
+
+    Recording starts automatically when the PARAMETRICEQ_TRACE_FILE
+    environment variable names an output file, or through start().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Shared between all plugin instances in the process through a
+    juce::SharedResourcePointer, so their events end up in one trace.
+*/
+class TraceRecorder : private juce::Thread
+{
+public:
+    TraceRecorder();
+    ~TraceRecorder() override;
+
+    void start(const juce::File& file);
+    void stop();
+    bool isRecording() const noexcept;
+
+    //Safe on the audio thread: no locks and no allocation. Names must be string literals.
+    static void beginEvent(const char* name) noexcept;
+    static void endEvent(const char* name) noexcept;
+
+    struct Scope
+    {
+        Scope(const char* eventName) noexcept : name(eventName) { beginEvent(name); }
+        ~Scope() noexcept { endEvent(name); }
+        const char* name;
+    };
+
+private:
+    struct Event
+    {
+        const char* name;
+        juce::int64 ticks;
+        char phase;
+    };
+
+    static constexpr int maxThreads = 64;
+    static constexpr juce::uint32 bufferSize = 8192;
+    static constexpr size_t chunkSize = 16384;
+
+    //Single producer (the owning thread), single consumer (the drain thread). Tagged with the
+    //operating system's id for the thread, so the trace lines up with system profilers.
+    struct ThreadBuffer
+    {
+        std::atomic<juce::uint32> writeIndex { 0 };
+        std::atomic<juce::uint32> readIndex { 0 };
+        std::atomic<juce::uint64> threadID { 0 };
+        Event events[bufferSize];
+    };
+
+    struct CollectedEvent
+    {
+        int thread;
+        Event event;
+    };
+
+    void record(const char* name, char phase) noexcept;
+    ThreadBuffer* getBufferForThisThread() noexcept;
+    void run() override;
+    void waitForWriters() const noexcept;
+    void drain();
+    void writeChunk();
+    void finishFile();
+
+    std::unique_ptr<ThreadBuffer[]> buffers;
+    std::atomic<int> numBuffersClaimed { 0 };
+    std::atomic<int> generation { 0 };
+    std::atomic<bool> recording { false };
+    std::atomic<int> activeWriters { 0 };
+    std::atomic<juce::uint32> droppedEvents { 0 };
+
+    //Drained events wait here until there is a chunk's worth to append to the file
+    juce::CriticalSection drainLock;
+    std::vector<CollectedEvent> collected;
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    static std::atomic<TraceRecorder*> instance;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
+
+#define PARAMETRICEQ_TRACE_SCOPE(name) TraceRecorder::Scope JUCE_JOIN_MACRO(traceScope, __LINE__) (name)
@@ -0,0 +1,363 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    Hammers one processor from every thread a host may call it on at once:
+    automation threads calling setValueNotifyingHost, MIDI threads feeding
+    controllers and program changes to a simulated audio thread running
+    processBlock, and the message thread saving and recalling the session,
+    storing programs and listening to the plots. Prints the automation
+    throughput and the callback times. Exits nonzero if the output ever stops
+    being finite, a MIDI event was dropped, a callback went over the block's
+    budget, or the filters left running disagree with the final parameters.
+    Build it with the ThreadSanitizer exporter to have the races reported as
+    well.
+
+    Usage: parametricEQStressTest [seconds] [automation threads] [block size]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//MIDI events from one MIDI thread to the audio thread
+class MidiEventQueue
+{
+public:
+    void push(const juce::MidiMessage& message)
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 > 0)
+            events[size_t(scope.startIndex1)] = message;
+        else
+            ++dropped;
+    }
+
+    void popInto(juce::MidiBuffer& buffer, int numSamples, juce::Random& random)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+        auto add = [&](int start, int size)
+        {
+            for (int i = start; i < start + size; ++i)
+                buffer.addEvent(events[size_t(i)], random.nextInt(numSamples));
+        };
+        add(scope.startIndex1, scope.blockSize1);
+        add(scope.startIndex2, scope.blockSize2);
+    }
+
+    std::atomic<int> dropped { 0 };
+
+private:
+    static constexpr int capacity = 1024;
+    juce::AbstractFifo fifo { capacity };
+    std::vector<juce::MidiMessage> events { size_t(capacity) };
+};
+
+//Calls setValueNotifyingHost on random parameters as fast as it can, as a host's automation thread would
+class AutomationThread : public juce::Thread
+{
+public:
+    AutomationThread(ParametricEQAudioProcessor& p, int index)
+        : juce::Thread("Automation " + juce::String(index)), parameters(p.getParameters()), random(index)
+    {
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            auto* parameter = parameters[random.nextInt(parameters.size())];
+            parameter->setValueNotifyingHost(random.nextFloat());
+            ++numChanges;
+        }
+    }
+
+    std::atomic<juce::int64> numChanges { 0 };
+
+private:
+    juce::Array<juce::AudioProcessorParameter*> parameters;
+    juce::Random random;
+};
+
+//Sends the automation controllers and program changes
+class MidiThread : public juce::Thread
+{
+public:
+    MidiThread(MidiEventQueue& q, int index)
+        : juce::Thread("MIDI " + juce::String(index)), queue(q), random(100 + index)
+    {
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            if (random.nextInt(16) == 0)
+                queue.push(juce::MidiMessage::programChange(1, random.nextInt(8)));
+            else
+                queue.push(juce::MidiMessage::controllerEvent(1, 102 + random.nextInt(16), random.nextInt(128)));
+            ++numEvents;
+
+            //A fast controller sweep, not a flood the fifo can't hold
+            juce::Thread::sleep(random.nextInt(2));
+        }
+    }
+
+    std::atomic<juce::int64> numEvents { 0 };
+
+private:
+    MidiEventQueue& queue;
+    juce::Random random;
+};
+
+//Runs processBlock back to back on fresh noise with whatever MIDI arrived since the last call
+class AudioThread : public juce::Thread
+{
+public:
+    AudioThread(ParametricEQAudioProcessor& p, std::vector<std::unique_ptr<MidiEventQueue>>& q, int numChannels, int blockSize)
+        : juce::Thread("Audio"), processor(p), queues(q), buffer(numChannels, blockSize)
+    {
+        midi.ensureSize(4096);
+    }
+
+    void run() override
+    {
+        juce::Random random(1);
+        while (!threadShouldExit())
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                for (int n = 0; n < buffer.getNumSamples(); ++n)
+                    buffer.setSample(ch, n, 0.5f * (random.nextFloat() - 0.5f));
+
+            midi.clear();
+            for (auto& queue : queues)
+                queue->popInto(midi, buffer.getNumSamples(), random);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            const auto ticks = juce::Time::getHighResolutionTicks() - start;
+
+            totalTicks += ticks;
+            maxTicks = juce::jmax(maxTicks.load(), ticks);
+            ++numCallbacks;
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                for (int n = 0; n < buffer.getNumSamples(); ++n)
+                    if (!std::isfinite(buffer.getSample(ch, n)))
+                        nonFinite = true;
+        }
+    }
+
+    std::atomic<juce::int64> numCallbacks { 0 };
+    std::atomic<juce::int64> totalTicks { 0 };
+    std::atomic<juce::int64> maxTicks { 0 };
+    std::atomic<bool> nonFinite { false };
+
+private:
+    ParametricEQAudioProcessor& processor;
+    std::vector<std::unique_ptr<MidiEventQueue>>& queues;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+};
+
+//Rounding between two runs of the same sections, far below any audible parameter difference
+static constexpr float maxDesignDifference = 1.0e-4f;
+
+//Stands in for an open editor
+struct PlotListener : public juce::ChangeListener
+{
+    void changeListenerCallback(juce::ChangeBroadcaster*) override { ++numUpdates; }
+    int numUpdates = 0;
+};
+
+static double ticksToMicroseconds(juce::int64 ticks)
+{
+    return 1.0e6 * double(ticks) / double(juce::Time::getHighResolutionTicksPerSecond());
+}
+
+//Runs silence through the processor on this thread, which finishes any program load and fade
+//and lets the filter state ring out
+static void settle(ParametricEQAudioProcessor& processor, int blockSize, double sampleRate)
+{
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), blockSize);
+    juce::MidiBuffer midi;
+    for (int n = 0; n < int(sampleRate); n += blockSize)
+    {
+        buffer.clear();
+        processor.processBlock(buffer, midi);
+    }
+}
+
+//The largest difference between the processor and a cascade designed afresh from its parameters,
+//on the same noise. Both run the same sections in the same order, so they should agree to rounding.
+static float compareWithParameters(ParametricEQAudioProcessor& processor, int blockSize, double sampleRate)
+{
+    using Processor = ParametricEQAudioProcessor;
+    const int numChannels = processor.getTotalNumOutputChannels();
+
+    BiquadCascade reference;
+    for (int i = 0; i < 4; ++i)
+    {
+        const float cutoff = *processor.tree.getRawParameterValue(processor.getFilterCutoffParamName(i));
+        const float q = *processor.tree.getRawParameterValue(processor.getFilterQParamName(i));
+        const float gainDB = *processor.tree.getRawParameterValue(processor.getFilterGainParamName(i));
+        const bool active = *processor.tree.getRawParameterValue(processor.getFilterActiveName(i)) >= 0.5f;
+        const int type = Processor::hasFilterType(i) ? juce::roundToInt(processor.tree.getRawParameterValue(processor.getFilterTypeName(i))->load()) : int(Processor::shelfType);
+        const int slope = Processor::hasFilterType(i) ? juce::roundToInt(processor.tree.getRawParameterValue(processor.getFilterSlopeName(i))->load()) : 0;
+
+        float sections[BiquadCascade::maxSectionsPerBand][5];
+        const int numSections = Processor::makeBandSections(i, type, slope, cutoff, q, gainDB, sampleRate, sections);
+        reference.setBandSections(i, sections, numSections);
+        reference.setBandBypassed(i, !active);
+    }
+    reference.prepare(numChannels);
+    reference.reset();
+
+    juce::AudioBuffer<float> processed(numChannels, blockSize), expected(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(3);
+    float maxDifference = 0.0f;
+    for (int block = 0; block < 100; ++block)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int n = 0; n < blockSize; ++n)
+                processed.setSample(ch, n, 0.5f * (random.nextFloat() - 0.5f));
+        expected.makeCopyOf(processed, true);
+
+        processor.processBlock(processed, midi);
+        reference.process(expected.getArrayOfWritePointers(), numChannels, blockSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int n = 0; n < blockSize; ++n)
+                maxDifference = juce::jmax(maxDifference, std::abs(processed.getSample(ch, n) - expected.getSample(ch, n)));
+    }
+    return maxDifference;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const int seconds = argc > 1 ? juce::jmax(1, juce::String(argv[1]).getIntValue()) : 10;
+    const int numAutomationThreads = argc > 2 ? juce::jmax(1, juce::String(argv[2]).getIntValue()) : 4;
+    const int blockSize = argc > 3 ? juce::jmax(1, juce::String(argv[3]).getIntValue()) : 64;
+    const int numMidiThreads = 2;
+    const double sampleRate = 48000.0;
+
+    ParametricEQAudioProcessor processor;
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    PlotListener plotListener;
+    processor.addPlotListener(&plotListener);
+
+    std::vector<std::unique_ptr<MidiEventQueue>> queues;
+    std::vector<std::unique_ptr<MidiThread>> midiThreads;
+    for (int i = 0; i < numMidiThreads; ++i)
+    {
+        queues.push_back(std::make_unique<MidiEventQueue>());
+        midiThreads.push_back(std::make_unique<MidiThread>(*queues.back(), i));
+    }
+
+    std::vector<std::unique_ptr<AutomationThread>> automationThreads;
+    for (int i = 0; i < numAutomationThreads; ++i)
+        automationThreads.push_back(std::make_unique<AutomationThread>(processor, i));
+
+    AudioThread audioThread(processor, queues, processor.getTotalNumOutputChannels(), blockSize);
+
+    std::cout << "Stressing for " << seconds << " s: " << numAutomationThreads << " automation threads, "
+              << numMidiThreads << " MIDI threads, " << blockSize << " samples per block" << std::endl;
+
+    audioThread.startThread(10);
+    for (auto& thread : midiThreads)
+        thread->startThread();
+    for (auto& thread : automationThreads)
+        thread->startThread();
+
+    //The message thread does what a host and an open editor do meanwhile
+    juce::Random random(2);
+    juce::MemoryBlock state;
+    int numRecalls = 0;
+    const auto end = juce::Time::getMillisecondCounter() + juce::uint32(seconds * 1000);
+    while (juce::Time::getMillisecondCounter() < end)
+    {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(10);
+
+        switch (random.nextInt(3))
+        {
+        case 0:
+            processor.getStateInformation(state);
+            processor.setStateInformation(state.getData(), int(state.getSize()));
+            ++numRecalls;
+            break;
+        case 1:
+            processor.storeProgram(random.nextInt(processor.getNumPrograms()));
+            break;
+        case 2:
+            processor.setCurrentProgram(random.nextInt(processor.getNumPrograms()));
+            break;
+        }
+    }
+
+    for (auto& thread : automationThreads)
+        thread->signalThreadShouldExit();
+    for (auto& thread : midiThreads)
+        thread->signalThreadShouldExit();
+    for (auto& thread : automationThreads)
+        thread->stopThread(1000);
+    for (auto& thread : midiThreads)
+        thread->stopThread(1000);
+    audioThread.stopThread(1000);
+
+    //Take in a program change still waiting for the audio thread, let the timer hand the last
+    //values back to the parameters before the listener goes, then apply what that designed
+    settle(processor, blockSize, sampleRate);
+    juce::MessageManager::getInstance()->runDispatchLoopUntil(100);
+    processor.removePlotListener(&plotListener);
+    settle(processor, blockSize, sampleRate);
+    const float designDifference = compareWithParameters(processor, blockSize, sampleRate);
+
+    juce::int64 numChanges = 0, numEvents = 0;
+    int numDropped = 0;
+    for (auto& thread : automationThreads)
+        numChanges += thread->numChanges;
+    for (auto& thread : midiThreads)
+        numEvents += thread->numEvents;
+    for (auto& queue : queues)
+        numDropped += queue->dropped;
+
+    const auto numCallbacks = juce::jmax(juce::int64(1), audioThread.numCallbacks.load());
+    const double budget = 1.0e6 * blockSize / sampleRate;
+    std::cout << "  automation: " << juce::String(double(numChanges) / seconds, 0) << " changes/s" << std::endl
+              << "  MIDI: " << juce::String(double(numEvents) / seconds, 0) << " events/s, " << numDropped << " dropped" << std::endl
+              << "  processBlock: " << numCallbacks << " calls, mean " << juce::String(ticksToMicroseconds(audioThread.totalTicks) / double(numCallbacks), 2)
+              << " us, max " << juce::String(ticksToMicroseconds(audioThread.maxTicks), 2)
+              << " us, budget " << juce::String(budget, 2) << " us" << std::endl
+              << "  message thread: " << numRecalls << " session recalls, " << plotListener.numUpdates << " plot updates" << std::endl
+              << "  final design: " << juce::String(designDifference, 8) << " largest difference from the parameters" << std::endl;
+
+    bool passed = true;
+    if (audioThread.nonFinite)
+    {
+        std::cout << "FAILED: the output was not finite" << std::endl;
+        passed = false;
+    }
+    if (numDropped > 0)
+    {
+        std::cout << "FAILED: " << numDropped << " MIDI events were dropped" << std::endl;
+        passed = false;
+    }
+    if (ticksToMicroseconds(audioThread.maxTicks) > budget)
+    {
+        std::cout << "FAILED: the slowest callback went over the block's budget" << std::endl;
+        passed = false;
+    }
+    if (!(designDifference <= maxDesignDifference))
+    {
+        std::cout << "FAILED: the filters don't match the final parameters" << std::endl;
+        passed = false;
+    }
+    return passed ? 0 : 1;
+}
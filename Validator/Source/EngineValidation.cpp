@@ -0,0 +1,364 @@
+/*
+  ==============================================================================
+
+    EngineValidation.cpp
+    Created: 19 Oct 2026 9:12:40am
+    Author:  jrgehrig
+
+  ==============================================================================
+*/
+
+#include "EngineValidation.h"
+
+juce::String EngineValidator::ProcessorChainEngine::getName() const
+{
+    return "ProcessorChain";
+}
+
+EngineValidator::Tolerance EngineValidator::ProcessorChainEngine::getTolerance() const
+{
+    //Float biquads designed with the RBJ formulas, checked against the prototype they are derived from
+    return { 0.0f, 0.0, 0.1, 1.0 };
+}
+
+void EngineValidator::ProcessorChainEngine::prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands)
+{
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = juce::uint32(maximumBlockSize);
+    spec.numChannels = juce::uint32(numChannels);
+
+    lowCut.clear();
+    highCut.clear();
+
+    bool bypassed[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        bypassed[i] = !bands[i].active;
+        if (bands[i].type == ParametricEQAudioProcessor::shelfType)
+        {
+            auto coefficients = ParametricEQAudioProcessor::makeBandCoefficients(i, bands[i].cutoff, bands[i].q, bands[i].gainDB, sampleRate);
+            ParametricEQAudioProcessor::getChainCoefficients(chain, i) = *coefficients;
+            continue;
+        }
+
+        //A cut takes its band's slot out of the chain
+        bypassed[i] = true;
+        if (!bands[i].active)
+            continue;
+
+        float sections[BiquadCascade::maxSectionsPerBand][5];
+        int numSections = ParametricEQAudioProcessor::makeBandSections(i, bands[i].type, bands[i].slope, bands[i].cutoff,
+                                                                       bands[i].q, bands[i].gainDB, sampleRate, sections);
+        for (int s = 0; s < numSections; ++s)
+        {
+            auto* section = (i == 0 ? lowCut : highCut).add(new ParametricEQAudioProcessor::FilterProcessor());
+            section->state = new juce::dsp::IIR::Coefficients<float>(sections[s][0], sections[s][1], sections[s][2], 1.0f, sections[s][3], sections[s][4]);
+            section->prepare(spec);
+            section->reset();
+        }
+    }
+    ParametricEQAudioProcessor::setChainBypassed(chain, bypassed);
+
+    chain.prepare(spec);
+    chain.reset();
+}
+
+void EngineValidator::ProcessorChainEngine::process(juce::AudioBuffer<float>& buffer)
+{
+    juce::dsp::AudioBlock<float> block(buffer);
+    juce::dsp::ProcessContextReplacing<float> context(block);
+
+    for (auto* section : lowCut)
+        section->process(context);
+    chain.process(context);
+    for (auto* section : highCut)
+        section->process(context);
+}
+
+//==============================================================================
+juce::String EngineValidator::BiquadCascadeEngine::getName() const
+{
+    return "BiquadCascade";
+}
+
+EngineValidator::Tolerance EngineValidator::BiquadCascadeEngine::getTolerance() const
+{
+    //Same arithmetic as IIR::Filter, only the loop structure differs
+    return { 1.0e-6f, 120.0, 0.1, 1.0 };
+}
+
+void EngineValidator::BiquadCascadeEngine::prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands)
+{
+    juce::ignoreUnused(maximumBlockSize);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        float sections[BiquadCascade::maxSectionsPerBand][5];
+        int numSections = ParametricEQAudioProcessor::makeBandSections(i, bands[i].type, bands[i].slope, bands[i].cutoff,
+                                                                       bands[i].q, bands[i].gainDB, sampleRate, sections);
+        cascade.setBandSections(i, sections, numSections);
+        cascade.setBandBypassed(i, !bands[i].active);
+    }
+
+    cascade.prepare(numChannels);
+    cascade.reset();
+}
+
+void EngineValidator::BiquadCascadeEngine::process(juce::AudioBuffer<float>& buffer)
+{
+    cascade.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+}
+
+//==============================================================================
+juce::String EngineValidator::TimeBlockedCascadeEngine::getName() const
+{
+    return "TimeBlockedCascade";
+}
+
+EngineValidator::Tolerance EngineValidator::TimeBlockedCascadeEngine::getTolerance() const
+{
+    //Rounds differently from the recursion, so it is not bit exact: about 80 dB SNR against it with
+    //steep cuts in the cascade, and closer than the recursion to a double precision reference
+    return { 5.0e-4f, 70.0, 0.1, 1.0 };
+}
+
+void EngineValidator::TimeBlockedCascadeEngine::prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands)
+{
+    BiquadCascadeEngine::prepare(sampleRate, numChannels, maximumBlockSize, bands);
+    cascade.setTimeBlockedProcessing(true);
+}
+
+//==============================================================================
+EngineValidator::EngineValidator(double rate, int size)
+    : sampleRate(rate), blockSize(size)
+{
+    createSignals();
+}
+
+void EngineValidator::addEngine(std::unique_ptr<Engine> engine)
+{
+    engines.push_back(std::move(engine));
+}
+
+void EngineValidator::addConfiguration(const BandSettings* bands)
+{
+    std::array<BandSettings, 4> configuration;
+    std::copy_n(bands, 4, configuration.begin());
+    configurations.push_back(configuration);
+}
+
+const juce::Array<EngineValidator::Result>& EngineValidator::getResults() const
+{
+    return results;
+}
+
+void EngineValidator::createSignals()
+{
+    const int numSamples = 1 << fftOrder;
+    juce::Random random(1234);
+
+    //Impulse: also used for the frequency response
+    auto* impulse = signals.add(new juce::AudioBuffer<float>(2, numSamples));
+    impulse->clear();
+    impulse->setSample(0, 0, 1.0f);
+    impulse->setSample(1, 0, 1.0f);
+    signalNames.add("Impulse");
+
+    //Exponential sine sweep 20 Hz - 20 kHz
+    auto* sweep = signals.add(new juce::AudioBuffer<float>(2, numSamples));
+    const double sweepEnd = juce::jmin(20000.0, 0.45 * sampleRate);
+    const double sweepRate = std::log(sweepEnd / 20.0);
+    const double duration = numSamples / sampleRate;
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double t = n / sampleRate;
+        double phase = juce::MathConstants<double>::twoPi * 20.0 * duration / sweepRate * (std::exp(t / duration * sweepRate) - 1.0);
+        sweep->setSample(0, n, float(0.5 * std::sin(phase)));
+        sweep->setSample(1, n, float(0.5 * std::sin(phase)));
+    }
+    signalNames.add("Sweep");
+
+    //White noise, fixed seed
+    auto* noise = signals.add(new juce::AudioBuffer<float>(2, numSamples));
+    for (int ch = 0; ch < 2; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            noise->setSample(ch, n, random.nextFloat() - 0.5f);
+    signalNames.add("Noise");
+
+    //A short burst followed by noise in the denormal range, so filter tails decay through it
+    auto* tail = signals.add(new juce::AudioBuffer<float>(2, numSamples));
+    tail->clear();
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        for (int n = 0; n < 64; ++n)
+            tail->setSample(ch, n, random.nextFloat() - 0.5f);
+        for (int n = numSamples / 2; n < numSamples; ++n)
+            tail->setSample(ch, n, (random.nextFloat() - 0.5f) * 1.0e-38f);
+    }
+    signalNames.add("Denormal tail");
+}
+
+void EngineValidator::render(Engine& engine, const BandSettings* bands, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+{
+    juce::ScopedNoDenormals noDenormals;
+    output.makeCopyOf(input);
+    engine.prepare(sampleRate, output.getNumChannels(), blockSize, bands);
+
+    //Rendered in host sized blocks so block boundary handling is part of what's compared
+    for (int start = 0; start < output.getNumSamples(); start += blockSize)
+    {
+        int numSamples = juce::jmin(blockSize, output.getNumSamples() - start);
+        juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), output.getNumChannels(), start, numSamples);
+        engine.process(block);
+    }
+}
+
+std::complex<double> EngineValidator::getAnalogPrototypeResponse(int index, const BandSettings& band, double frequency, double sampleRate)
+{
+    if (!band.active)
+        return 1.0;
+
+    //RBJ prototypes, evaluated at the frequency the bilinear transform maps onto this one
+    const double A = std::sqrt(juce::Decibels::decibelsToGain(double(band.gainDB)));
+    const double q = band.q;
+    const double pi = juce::MathConstants<double>::pi;
+    const std::complex<double> s(0.0, std::tan(pi * frequency / sampleRate) / std::tan(pi * band.cutoff / sampleRate));
+
+    //Cuts: a Butterworth of the full order, or Linkwitz-Riley as one of half the order squared
+    if (band.type != ParametricEQAudioProcessor::shelfType)
+    {
+        const int slopeDB = ParametricEQAudioProcessor::getSlopeDBPerOctave(band.slope);
+        if (band.type == ParametricEQAudioProcessor::linkwitzRileyCut)
+            return std::pow(getButterworthResponse(slopeDB / 12, s, index == 0), 2);
+        return getButterworthResponse(slopeDB / 6, s, index == 0);
+    }
+
+    switch (index)
+    {
+    case 0: return A * (s * s + (std::sqrt(A) / q) * s + A) / (A * s * s + (std::sqrt(A) / q) * s + 1.0); break;
+    case 3: return A * (A * s * s + (std::sqrt(A) / q) * s + 1.0) / (s * s + (std::sqrt(A) / q) * s + A); break;
+    }
+    return (s * s + (A / q) * s + 1.0) / (s * s + s / (A * q) + 1.0);
+}
+
+std::complex<double> EngineValidator::getButterworthResponse(int order, std::complex<double> s, bool highPass)
+{
+    //Poles evenly spaced around the left half of the unit circle, independent of how the sections are split
+    std::complex<double> denominator(1.0);
+    for (int k = 0; k < order; ++k)
+        denominator *= s - std::polar(1.0, juce::MathConstants<double>::pi * (2 * k + order + 1) / (2.0 * order));
+
+    return (highPass ? std::pow(s, order) : std::complex<double>(1.0)) / denominator;
+}
+
+void EngineValidator::measureResponse(const juce::AudioBuffer<float>& impulseResponse, const BandSettings* bands, Result& result)
+{
+    const int size = 1 << fftOrder;
+    juce::dsp::FFT fft(fftOrder);
+    std::vector<float> data(size_t(2 * size), 0.0f);
+    std::copy_n(impulseResponse.getReadPointer(0), size, data.begin());
+    fft.performRealOnlyForwardTransform(data.data(), true);
+
+    const double maxFrequency = juce::jmin(20000.0, 0.45 * sampleRate);
+    for (int k = 1; k <= size / 2; ++k)
+    {
+        double frequency = k * sampleRate / size;
+        if (frequency < 20.0 || frequency > maxFrequency)
+            continue;
+
+        std::complex<double> measured(data[size_t(2 * k)], data[size_t(2 * k + 1)]);
+        std::complex<double> expected(1.0);
+        for (int i = 0; i < 4; ++i)
+            expected *= getAnalogPrototypeResponse(i, bands[i], frequency, sampleRate);
+
+        //Deep in a cut's stop band the measurement is mostly rounding noise
+        if (std::abs(expected) < 1.0e-4)
+            continue;
+
+        double magnitudeError = std::abs(juce::Decibels::gainToDecibels(std::abs(measured), -200.0)
+                                       - juce::Decibels::gainToDecibels(std::abs(expected), -200.0));
+        double phaseError = std::abs(std::arg(measured / expected)) * 180.0 / juce::MathConstants<double>::pi;
+        result.magnitudeErrorDB = juce::jmax(result.magnitudeErrorDB, magnitudeError);
+        result.phaseErrorDegrees = juce::jmax(result.phaseErrorDegrees, phaseError);
+    }
+}
+
+bool EngineValidator::run()
+{
+    results.clear();
+    if (engines.empty())
+        return true;
+
+    bool allPassed = true;
+    juce::AudioBuffer<float> reference;
+    juce::AudioBuffer<float> output;
+
+    for (size_t c = 0; c < configurations.size(); ++c)
+    {
+        const auto* bands = configurations[c].data();
+        for (int s = 0; s < signals.size(); ++s)
+        {
+            render(*engines.front(), bands, *signals[s], reference);
+
+            for (auto& engine : engines)
+            {
+                render(*engine, bands, *signals[s], output);
+
+                Result result;
+                result.engineName = engine->getName();
+                result.signalName = signalNames[s];
+                result.configuration = int(c);
+
+                double referenceEnergy = 0.0;
+                double errorEnergy = 0.0;
+                bool finite = true;
+                for (int ch = 0; ch < output.getNumChannels(); ++ch)
+                {
+                    const auto* ref = reference.getReadPointer(ch);
+                    const auto* out = output.getReadPointer(ch);
+                    for (int n = 0; n < output.getNumSamples(); ++n)
+                    {
+                        finite = finite && std::isfinite(out[n]);
+                        float error = out[n] - ref[n];
+                        result.maxAbsError = juce::jmax(result.maxAbsError, std::abs(error));
+                        referenceEnergy += double(ref[n]) * ref[n];
+                        errorEnergy += double(error) * error;
+                    }
+                }
+                result.snrDB = errorEnergy > 0.0 ? 10.0 * std::log10(referenceEnergy / errorEnergy) : 300.0;
+
+                if (s == 0)
+                    measureResponse(output, bands, result);
+
+                const auto tolerance = engine->getTolerance();
+                //SNR is meaningless for the denormal range signal, there the absolute error is what counts
+                bool snrMatters = referenceEnergy > 1.0e-20;
+                result.passed = finite
+                    && result.maxAbsError <= tolerance.maxAbsError
+                    && (!snrMatters || result.snrDB >= tolerance.minSnrDB)
+                    && result.magnitudeErrorDB <= tolerance.maxMagnitudeErrorDB
+                    && result.phaseErrorDegrees <= tolerance.maxPhaseErrorDegrees;
+
+                allPassed = allPassed && result.passed;
+                results.add(result);
+            }
+        }
+    }
+    return allPassed;
+}
+
+juce::String EngineValidator::getReport() const
+{
+    juce::String report;
+    for (auto& result : results)
+    {
+        report << (result.passed ? "PASS " : "FAIL ")
+               << result.engineName << " / config " << result.configuration << " / " << result.signalName
+               << ": max abs " << juce::String(result.maxAbsError, 9)
+               << ", SNR " << juce::String(result.snrDB, 1) << " dB"
+               << ", mag " << juce::String(result.magnitudeErrorDB, 4) << " dB"
+               << ", phase " << juce::String(result.phaseErrorDegrees, 3) << " deg" << juce::newLine;
+    }
+    return report;
+}
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    EngineValidation.h
+    Created: 19 Oct 2026 9:12:40am
+    Author:  jrgehrig
+
+    Accuracy checks for alternative processing engines. Every engine renders
+    the same test signals as the ProcessorChain reference and is compared
+    against it sample by sample, and its impulse response is compared against
+    the analog prototype of the bands it was set up with.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+/**
+*/
+class EngineValidator
+{
+public:
+    struct BandSettings
+    {
+        float cutoff;
+        float q;
+        float gainDB;
+        bool active;
+        int type = ParametricEQAudioProcessor::shelfType;
+        int slope = 0;
+    };
+
+    //Limits an engine documents for itself. Time domain limits are against the
+    //ProcessorChain output, frequency domain limits against the analog prototype.
+    struct Tolerance
+    {
+        float maxAbsError;
+        double minSnrDB;
+        double maxMagnitudeErrorDB;
+        double maxPhaseErrorDegrees;
+    };
+
+    struct Result
+    {
+        juce::String engineName;
+        juce::String signalName;
+        int configuration = 0;
+        float maxAbsError = 0.0f;
+        double snrDB = 0.0;
+        double magnitudeErrorDB = 0.0;
+        double phaseErrorDegrees = 0.0;
+        bool passed = true;
+    };
+
+    class Engine
+    {
+    public:
+        virtual ~Engine() = default;
+        virtual juce::String getName() const = 0;
+        virtual Tolerance getTolerance() const = 0;
+        virtual void prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands) = 0;
+        virtual void process(juce::AudioBuffer<float>& buffer) = 0;
+    };
+
+    //The processor's own path: four ProcessorDuplicators in a ProcessorChain. Cut sections run
+    //in extra duplicators before and after the chain, in the order the cascade runs them.
+    class ProcessorChainEngine : public Engine
+    {
+    public:
+        juce::String getName() const override;
+        Tolerance getTolerance() const override;
+        void prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands) override;
+        void process(juce::AudioBuffer<float>& buffer) override;
+
+    private:
+        ParametricEQAudioProcessor::FilterChain chain;
+        juce::OwnedArray<ParametricEQAudioProcessor::FilterProcessor> lowCut;
+        juce::OwnedArray<ParametricEQAudioProcessor::FilterProcessor> highCut;
+    };
+
+    //The cascade the processor actually runs
+    class BiquadCascadeEngine : public Engine
+    {
+    public:
+        juce::String getName() const override;
+        Tolerance getTolerance() const override;
+        void prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands) override;
+        void process(juce::AudioBuffer<float>& buffer) override;
+
+    protected:
+        BiquadCascade cascade;
+    };
+
+    //The same cascade with the block state-space kernel offline renders use
+    class TimeBlockedCascadeEngine : public BiquadCascadeEngine
+    {
+    public:
+        juce::String getName() const override;
+        Tolerance getTolerance() const override;
+        void prepare(double sampleRate, int numChannels, int maximumBlockSize, const BandSettings* bands) override;
+    };
+
+    EngineValidator(double sampleRate, int blockSize);
+
+    //The first engine added is the time domain reference for all others
+    void addEngine(std::unique_ptr<Engine> engine);
+    void addConfiguration(const BandSettings* bands);
+
+    bool run();
+    const juce::Array<Result>& getResults() const;
+    juce::String getReport() const;
+
+    static std::complex<double> getAnalogPrototypeResponse(int index, const BandSettings& band, double frequency, double sampleRate);
+    static std::complex<double> getButterworthResponse(int order, std::complex<double> s, bool highPass);
+
+private:
+    void createSignals();
+    void render(Engine& engine, const BandSettings* bands, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output);
+    void measureResponse(const juce::AudioBuffer<float>& impulseResponse, const BandSettings* bands, Result& result);
+
+    double sampleRate;
+    int blockSize;
+    int fftOrder = 16;
+
+    std::vector<std::unique_ptr<Engine>> engines;
+    std::vector<std::array<BandSettings, 4>> configurations;
+    juce::StringArray signalNames;
+    juce::OwnedArray<juce::AudioBuffer<float>> signals;
+    juce::Array<Result> results;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EngineValidator)
+};
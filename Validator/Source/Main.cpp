@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    Checks every processing engine against the ProcessorChain reference for
+    the factory programs and a set of cut configurations, at several sample
+    rates and block sizes. Prints the report and exits nonzero if any engine
+    is out of its tolerance.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "EngineValidation.h"
+
+//The bands a program sets, read back from the processor's parameters
+static void readProgramBands(ParametricEQAudioProcessor& processor, int program, EngineValidator::BandSettings* bands)
+{
+    processor.setCurrentProgram(program);
+    for (int i = 0; i < 4; ++i)
+    {
+        bands[i].cutoff = *processor.tree.getRawParameterValue(processor.getFilterCutoffParamName(i));
+        bands[i].q = *processor.tree.getRawParameterValue(processor.getFilterQParamName(i));
+        bands[i].gainDB = *processor.tree.getRawParameterValue(processor.getFilterGainParamName(i));
+        bands[i].active = *processor.tree.getRawParameterValue(processor.getFilterActiveName(i)) >= 0.5f;
+        bands[i].type = ParametricEQAudioProcessor::shelfType;
+        bands[i].slope = 0;
+        if (ParametricEQAudioProcessor::hasFilterType(i))
+        {
+            bands[i].type = juce::roundToInt(processor.tree.getRawParameterValue(processor.getFilterTypeName(i))->load());
+            bands[i].slope = juce::roundToInt(processor.tree.getRawParameterValue(processor.getFilterSlopeName(i))->load());
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ignoreUnused(argc, argv);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::vector<std::array<EngineValidator::BandSettings, 4>> configurations;
+    {
+        ParametricEQAudioProcessor processor;
+        for (int p = 0; p < processor.getNumPrograms(); ++p)
+        {
+            configurations.emplace_back();
+            readProgramBands(processor, p, configurations.back().data());
+        }
+    }
+
+    //The factory bank is all shelves, so the cuts get configurations of their own
+    using Settings = EngineValidator::BandSettings;
+    const Settings butterworth = { 100.0f, 0.7f, 0.0f, true, ParametricEQAudioProcessor::butterworthCut, 3 };
+    const Settings linkwitzRiley = { 60.0f, 0.7f, 0.0f, true, ParametricEQAudioProcessor::linkwitzRileyCut, 1 };
+    configurations.push_back({ butterworth, Settings { 883.9f, 5.7f, 0.0f, false }, Settings { 883.9f, 5.7f, 0.0f, false },
+                               Settings { 8000.0f, 0.7f, 0.0f, true, ParametricEQAudioProcessor::linkwitzRileyCut, 3 } });
+    configurations.push_back({ linkwitzRiley, Settings { 400.0f, 1.0f, -3.0f, true }, Settings { 3000.0f, 1.2f, 2.0f, true },
+                               Settings { 12000.0f, 0.7f, 0.0f, true, ParametricEQAudioProcessor::butterworthCut, 5 } });
+
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const int blockSizes[] = { 1, 64, 512 };
+
+    bool allPassed = true;
+    for (auto sampleRate : sampleRates)
+    {
+        for (auto blockSize : blockSizes)
+        {
+            //The first engine is the reference
+            EngineValidator validator(sampleRate, blockSize);
+            validator.addEngine(std::make_unique<EngineValidator::ProcessorChainEngine>());
+            validator.addEngine(std::make_unique<EngineValidator::BiquadCascadeEngine>());
+            validator.addEngine(std::make_unique<EngineValidator::TimeBlockedCascadeEngine>());
+            for (auto& bands : configurations)
+                validator.addConfiguration(bands.data());
+
+            const bool passed = validator.run();
+            std::cout << "== " << sampleRate << " Hz, " << blockSize << " samples per block: "
+                      << (passed ? "passed" : "FAILED") << std::endl
+                      << validator.getReport() << std::endl;
+            allPassed = passed && allPassed;
+        }
+    }
+
+    return allPassed ? 0 : 1;
+}